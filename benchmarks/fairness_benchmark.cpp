@@ -0,0 +1,76 @@
+// Measures how long producers wait to get into a full queue, with barging
+// and fifo fairness. Many producers contend for a small bounded queue while
+// one consumer drains it; the spread between p50 and p999 push latency is
+// the tail effect of unfair wakeups.
+#include <async_queue/async_queue.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace async_queue;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr int PRODUCERS = 8;
+constexpr int ITEMS_PER_PRODUCER = 20000;
+constexpr size_t CAPACITY = 4;
+
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+void run(const char* name, Fairness fairness) {
+    AsyncQueue<int> queue(CAPACITY, fairness);
+    std::vector<std::vector<double>> latencies(PRODUCERS);
+
+    auto start = Clock::now();
+    std::thread consumer([&]() {
+        while (queue.pop()) {
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p]() {
+            auto& samples = latencies[p];
+            samples.reserve(ITEMS_PER_PRODUCER);
+            for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                auto t0 = Clock::now();
+                queue.push(i);
+                samples.push_back(
+                    std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+            }
+        });
+    }
+
+    for (auto& p : producers) p.join();
+    queue.close();
+    consumer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    for (auto& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    std::printf("%-8s %10.0f items/s  push latency us: p50 %8.1f  p99 %8.1f  "
+                "p999 %8.1f  max %9.1f\n",
+                name, static_cast<double>(all.size()) / seconds,
+                percentile(all, 0.50), percentile(all, 0.99),
+                percentile(all, 0.999), all.back());
+}
+
+} // namespace
+
+int main() {
+    std::printf("%d producers, capacity %zu, %d items each\n",
+                PRODUCERS, CAPACITY, ITEMS_PER_PRODUCER);
+    run("barging", Fairness::barging);
+    run("fifo", Fairness::fifo);
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <async_queue/async_queue.hpp>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+    async_queue::AsyncQueue<int> queue(16);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 2; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < 5; ++i) {
+                queue.push(p * 100 + i);
+            }
+        });
+    }
+
+    std::thread consumer([&queue]() {
+        while (auto value = queue.pop()) {
+            std::cout << "Received: " << *value << std::endl;
+        }
+    });
+
+    for (auto& p : producers) p.join();
+    queue.close();
+    consumer.join();
+    return 0;
+}
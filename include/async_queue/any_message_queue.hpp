@@ -0,0 +1,459 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace async_queue {
+
+namespace detail {
+
+// Ring of variable-size records in one fixed buffer. Each record is a
+// 16-byte header followed by its payload, padded to a multiple of align.
+// A record that does not fit before the end of the buffer starts over at
+// the front, and the unused tail becomes a pad record that readers skip.
+//
+// Writing is two-phase: prepare() finds room, the caller constructs the
+// payload, and commit() publishes it. If construction throws, nothing was
+// committed and the ring is unchanged. Not thread-safe.
+class ByteRing {
+public:
+    static constexpr size_t align = 16;
+
+private:
+    struct alignas(align) Block {
+        unsigned char bytes[align];
+    };
+
+    struct Header {
+        size_t bytes;       // whole record, header included
+        const void* tag;    // nullptr marks a pad record
+    };
+    static_assert(sizeof(Header) <= align, "record header must fit one block");
+
+    std::unique_ptr<Block[]> buffer_;
+    size_t capacity_;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+    size_t used_ = 0;        // bytes held by records, pads included
+    size_t prepared_at_ = 0;
+    size_t prepared_bytes_ = 0;
+
+    unsigned char* at(size_t offset) const {
+        return buffer_[0].bytes + offset;
+    }
+
+    Header* header(size_t offset) const {
+        return reinterpret_cast<Header*>(at(offset));
+    }
+
+    bool full() const {
+        return used_ == capacity_;
+    }
+
+    void write_header(size_t offset, size_t bytes, const void* tag) {
+        ::new (static_cast<void*>(at(offset))) Header{bytes, tag};
+    }
+
+    void release_front() {
+        size_t bytes = header(head_)->bytes;
+        used_ -= bytes;
+        head_ += bytes;
+        if (head_ == capacity_) {
+            head_ = 0;
+        }
+    }
+
+public:
+    static size_t round_up(size_t bytes) {
+        return (bytes + align - 1) / align * align;
+    }
+
+    static size_t record_size(size_t payload) {
+        return align + round_up(payload);
+    }
+
+    explicit ByteRing(size_t capacity)
+        : buffer_(new Block[std::max<size_t>(round_up(capacity), align) / align]),
+          capacity_(std::max<size_t>(round_up(capacity), align)) {}
+
+    // Room for a payload of the given size, or nullptr if it does not fit.
+    void* prepare(size_t payload) {
+        size_t need = record_size(payload);
+        if (used_ == 0) {
+            head_ = tail_ = 0;
+        }
+        if (!full() && tail_ >= head_) {
+            if (capacity_ - tail_ >= need) {
+                prepared_at_ = tail_;
+            } else if (head_ >= need) {
+                prepared_at_ = 0;
+            } else {
+                return nullptr;
+            }
+        } else if (!full() && head_ - tail_ >= need) {
+            prepared_at_ = tail_;
+        } else {
+            return nullptr;
+        }
+        prepared_bytes_ = need;
+        return at(prepared_at_ + align);
+    }
+
+    // Publish the record from the last prepare() under the given tag.
+    void commit(const void* tag) {
+        if (prepared_at_ != tail_) {
+            // Wrapped: pad out the end of the buffer.
+            write_header(tail_, capacity_ - tail_, nullptr);
+            used_ += capacity_ - tail_;
+        }
+        write_header(prepared_at_, prepared_bytes_, tag);
+        used_ += prepared_bytes_;
+        tail_ = prepared_at_ + prepared_bytes_;
+        if (tail_ == capacity_) {
+            tail_ = 0;
+        }
+    }
+
+    // Payload of the oldest record and its tag, or nullptr if empty.
+    void* front(const void*& tag) {
+        while (used_ > 0 && header(head_)->tag == nullptr) {
+            release_front();
+        }
+        if (used_ == 0) {
+            return nullptr;
+        }
+        tag = header(head_)->tag;
+        return at(head_ + align);
+    }
+
+    // Release the record returned by front().
+    void pop() {
+        release_front();
+    }
+
+    bool empty() const {
+        return used_ == 0;
+    }
+
+    size_t used() const {
+        return used_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+};
+
+// Per-type operations for a message stored in an AnyMessageQueue. Boxed
+// messages are too big (or too strict) to store inline; the ring then
+// holds a pointer to a heap copy.
+struct MessageOps {
+    const void* type;
+    bool boxed;
+    void (*relocate)(void* from, void* to) noexcept;  // move, destroy source
+    void (*destroy)(void* payload) noexcept;
+};
+
+template<typename M>
+struct TypeTag {
+    static constexpr char id = 0;
+};
+
+template<typename M>
+constexpr const void* type_id() {
+    return &TypeTag<M>::id;
+}
+
+template<typename M>
+void relocate_inline(void* from, void* to) noexcept {
+    M* source = std::launder(static_cast<M*>(from));
+    ::new (to) M(std::move(*source));
+    source->~M();
+}
+
+template<typename M>
+void destroy_inline(void* payload) noexcept {
+    std::launder(static_cast<M*>(payload))->~M();
+}
+
+inline void relocate_boxed(void* from, void* to) noexcept {
+    std::memcpy(to, from, sizeof(void*));
+}
+
+template<typename M>
+void destroy_boxed(void* payload) noexcept {
+    M* boxed;
+    std::memcpy(&boxed, payload, sizeof(boxed));
+    delete boxed;
+}
+
+template<typename M, bool Boxed>
+inline constexpr MessageOps message_ops = {
+    type_id<M>(), false, &relocate_inline<M>, &destroy_inline<M>,
+};
+
+template<typename M>
+inline constexpr MessageOps message_ops<M, true> = {
+    type_id<M>(), true, &relocate_boxed, &destroy_boxed<M>,
+};
+
+} // namespace detail
+
+// A message popped from an AnyMessageQueue, valid while the visitor runs.
+class MessageRef {
+    const detail::MessageOps* ops_;
+    void* payload_;
+
+public:
+    MessageRef(const detail::MessageOps* ops, void* payload)
+        : ops_(ops), payload_(payload) {}
+
+    template<typename M>
+    bool is() const {
+        return ops_->type == detail::type_id<M>();
+    }
+
+    // Requires is<M>().
+    template<typename M>
+    M& get() const {
+        if (ops_->boxed) {
+            M* boxed;
+            std::memcpy(&boxed, payload_, sizeof(boxed));
+            return *boxed;
+        }
+        return *std::launder(static_cast<M*>(payload_));
+    }
+
+    // Identifies the message type; equal for messages of the same type.
+    const void* type() const {
+        return ops_->type;
+    }
+};
+
+// Call f with the message as the first of Ts it holds. Returns false, not
+// calling f, if it is none of them.
+template<typename... Ts, typename F>
+bool visit(const MessageRef& message, F&& f) {
+    bool matched = false;
+    auto one = [&](auto* tag) {
+        using M = std::remove_pointer_t<decltype(tag)>;
+        if (!matched && message.is<M>()) {
+            matched = true;
+            f(message.get<M>());
+        }
+    };
+    (one(static_cast<Ts*>(nullptr)), ...);
+    return matched;
+}
+
+// FIFO queue of messages of any type, without a heap allocation or a
+// virtual call per message.
+//
+// Messages are stored in a single byte ring, each one in a record sized
+// for its type and tagged with a pointer to that type's ops table. Types of
+// up to MaxInline bytes (and nothrow movable) are stored inline; larger
+// ones fall back to one heap allocation. The capacity is in bytes. pop()
+// moves the message onto the consumer's stack, frees its ring space, and
+// hands it to a visitor as a MessageRef outside the lock.
+template<size_t MaxInline = 64>
+class AnyMessageQueue {
+public:
+    // Whether messages of type M are stored without allocating.
+    template<typename M>
+    static constexpr bool stores_inline =
+        sizeof(M) <= MaxInline && alignof(M) <= detail::ByteRing::align &&
+        std::is_nothrow_move_constructible_v<M>;
+
+protected:
+    static constexpr size_t local_size = std::max(MaxInline, sizeof(void*));
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    detail::ByteRing ring_;
+    size_t size_ = 0;
+    bool closed_ = false;
+
+    template<typename M>
+    static size_t payload_size() {
+        return stores_inline<M> ? sizeof(M) : sizeof(M*);
+    }
+
+    template<typename U>
+    void store(void* slot, U&& message) {
+        using M = std::decay_t<U>;
+        if constexpr (stores_inline<M>) {
+            ::new (slot) M(std::forward<U>(message));
+        } else {
+            M* boxed = new M(std::forward<U>(message));
+            std::memcpy(slot, &boxed, sizeof(boxed));
+        }
+        ring_.commit(&detail::message_ops<M, !stores_inline<M>>);
+        ++size_;
+        not_empty_.notify_one();
+    }
+
+    // Move the oldest message into local; returns its ops. Requires
+    // size_ > 0.
+    const detail::MessageOps* take(void* local) {
+        const void* tag = nullptr;
+        void* payload = ring_.front(tag);
+        auto ops = static_cast<const detail::MessageOps*>(tag);
+        ops->relocate(payload, local);
+        ring_.pop();
+        --size_;
+        // Freed bytes may fit several waiting producers of different sizes.
+        not_full_.notify_all();
+        return ops;
+    }
+
+    template<typename F>
+    static void dispatch(const detail::MessageOps* ops, void* local, F& visitor) {
+        struct Destroy {
+            const detail::MessageOps* ops;
+            void* payload;
+            ~Destroy() { ops->destroy(payload); }
+        } guard{ops, local};
+        visitor(MessageRef(ops, local));
+    }
+
+public:
+    // capacity_bytes is rounded up to hold at least one inline message.
+    explicit AnyMessageQueue(size_t capacity_bytes = 64 * 1024)
+        : ring_(std::max(capacity_bytes, detail::ByteRing::record_size(local_size))) {}
+
+    ~AnyMessageQueue() {
+        const void* tag = nullptr;
+        while (void* payload = ring_.front(tag)) {
+            static_cast<const detail::MessageOps*>(tag)->destroy(payload);
+            ring_.pop();
+        }
+    }
+
+    AnyMessageQueue(const AnyMessageQueue&) = delete;
+    AnyMessageQueue& operator=(const AnyMessageQueue&) = delete;
+
+    // Wait for ring space, then enqueue. Returns false if the queue is
+    // closed.
+    template<typename U>
+    bool push(U&& message) {
+        using M = std::decay_t<U>;
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        void* slot = nullptr;
+        not_full_.wait(lock, [&] {
+            return closed_ || (slot = ring_.prepare(payload_size<M>())) != nullptr;
+        });
+
+        if (closed_) {
+            return false;
+        }
+
+        store(slot, std::forward<U>(message));
+        return true;
+    }
+
+    // Like push, but gives up after timeout. The message is only moved
+    // from if it was queued.
+    template<typename U, typename Rep, typename Period>
+    bool try_push(U&& message, const std::chrono::duration<Rep, Period>& timeout) {
+        using M = std::decay_t<U>;
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        void* slot = nullptr;
+        if (!not_full_.wait_for(lock, timeout, [&] {
+            return closed_ || (slot = ring_.prepare(payload_size<M>())) != nullptr;
+        })) {
+            return false;
+        }
+
+        if (closed_) {
+            return false;
+        }
+
+        store(slot, std::forward<U>(message));
+        return true;
+    }
+
+    // Wait for a message and call visitor(MessageRef) with it. Returns
+    // false once the queue is closed and empty.
+    template<typename F>
+    bool pop(F&& visitor) {
+        alignas(detail::ByteRing::align) unsigned char local[local_size];
+        const detail::MessageOps* ops;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this] {
+                return size_ > 0 || closed_;
+            });
+            if (size_ == 0) {
+                return false;
+            }
+            ops = take(local);
+        }
+        dispatch(ops, local, visitor);
+        return true;
+    }
+
+    template<typename F, typename Rep, typename Period>
+    bool try_pop(F&& visitor, const std::chrono::duration<Rep, Period>& timeout) {
+        alignas(detail::ByteRing::align) unsigned char local[local_size];
+        const detail::MessageOps* ops;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait_for(lock, timeout, [this] {
+                return size_ > 0 || closed_;
+            });
+            if (size_ == 0) {
+                return false;
+            }
+            ops = take(local);
+        }
+        dispatch(ops, local, visitor);
+        return true;
+    }
+
+    // Stop accepting messages; consumers drain what is left.
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    bool is_closed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_ == 0;
+    }
+
+    // Number of pending messages.
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    // Ring bytes in use, record headers and padding included.
+    size_t bytes_used() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ring_.used();
+    }
+
+    size_t capacity_bytes() const {
+        return ring_.capacity();
+    }
+};
+
+} // namespace async_queue
@@ -0,0 +1,528 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include "async_queue/stop_token.hpp"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace async_queue {
+
+// Sender/receiver-style asynchronous pop and push, modelled on P2300 but
+// written for C++17: no std::execution, no coroutines.
+//
+// async_pop(queue), async_push(queue, item) and when_any(async_pop(a),
+// async_pop(b), ...) return senders. connect(sender, receiver) returns an
+// operation state, which must stay put until it completes; start() begins
+// it. A waiting operation is parked on the queue's own intrusive waiter
+// list, the same way a blocked thread is, so waiting allocates nothing and
+// needs no thread.
+//
+// A receiver provides:
+//   set_value(value_type)  - the sender's result
+//   set_stopped()          - cancelled through the stop token
+//   get_scheduler()        - where the receiver is to be called
+//   get_stop_token()       - optional; a StopToken that cancels the wait
+//
+// The receiver is always called from a Work item posted to its scheduler,
+// never inside start() or under a queue's lock. It may destroy the
+// operation state from set_value/set_stopped.
+
+// Intrusive unit of work for a scheduler.
+struct Work {
+    void (*execute)(Work*) = nullptr;
+    Work* next = nullptr;
+};
+
+// Minimal execution context: work posted from any thread runs on the
+// thread calling run() or poll(). A scheduler is anything with a
+// post(Work&) that queues the work without running it inline; posting
+// happens with a queue's mutex held.
+class RunLoop {
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    Work* head_ = nullptr;
+    Work* tail_ = nullptr;
+    bool finishing_ = false;
+
+    Work* take() {
+        Work* work = head_;
+        head_ = work->next;
+        if (!head_) {
+            tail_ = nullptr;
+        }
+        return work;
+    }
+
+public:
+    class Scheduler {
+        RunLoop* loop_;
+
+    public:
+        explicit Scheduler(RunLoop* loop) : loop_(loop) {}
+
+        void post(Work& work) const {
+            loop_->post(work);
+        }
+
+        bool operator==(const Scheduler& other) const { return loop_ == other.loop_; }
+        bool operator!=(const Scheduler& other) const { return loop_ != other.loop_; }
+    };
+
+    Scheduler get_scheduler() {
+        return Scheduler(this);
+    }
+
+    void post(Work& work) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        work.next = nullptr;
+        (tail_ ? tail_->next : head_) = &work;
+        tail_ = &work;
+        cv_.notify_one();
+    }
+
+    // Run posted work until finish() is called and nothing is left.
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] {
+                return head_ || finishing_;
+            });
+            if (!head_) {
+                return;
+            }
+            Work* work = take();
+            lock.unlock();
+            work->execute(work);
+            lock.lock();
+        }
+    }
+
+    // Run the work posted so far without waiting. Returns how much ran.
+    size_t poll() {
+        size_t ran = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (head_) {
+            Work* work = take();
+            lock.unlock();
+            work->execute(work);
+            ++ran;
+            lock.lock();
+        }
+        return ran;
+    }
+
+    void finish() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finishing_ = true;
+        cv_.notify_all();
+    }
+};
+
+namespace detail {
+
+// Access to a queue's waiter lists for the operations below.
+struct Async {
+    template<typename T>
+    using PopWaiter = typename AsyncQueue<T>::PopWaiter;
+    template<typename T>
+    using PushWaiter = typename AsyncQueue<T>::PushWaiter;
+
+    // Serve the waiter now if an item is stored or the queue is closed,
+    // otherwise park it. Does nothing if the claim fails.
+    template<typename T>
+    static void pop_or_park(AsyncQueue<T>& queue, PopWaiter<T>& waiter) {
+        std::unique_lock<std::mutex> lock(queue.mutex_);
+        if (queue.size_ == 0 && !queue.closed_) {
+            queue.parked_consumers_.push_back(&waiter);
+            return;
+        }
+        if (waiter.async->claim()) {
+            if (queue.size_ > 0) {
+                waiter.item.emplace(queue.pop_stored());
+            }
+            waiter.async->wake();
+        }
+        queue.run_drop_handler(lock);
+    }
+
+    // Unlink the waiter if it is still parked and take what it was given.
+    template<typename T>
+    static std::optional<T> unpark(AsyncQueue<T>& queue, PopWaiter<T>& waiter) {
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        return queue.unpark(waiter);
+    }
+
+    // Push now if the queue has room (or report it closed), otherwise park
+    // the waiter in admission order. Sets pushed if the item went in.
+    template<typename T>
+    static void push_or_park(AsyncQueue<T>& queue, PushWaiter<T>& waiter, T& item,
+                             bool& pushed) {
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        if (!queue.closed_ && !queue.may_enter(waiter.priority)) {
+            queue.park(&waiter);
+            return;
+        }
+        if (waiter.async->claim()) {
+            if (!queue.closed_) {
+                queue.deliver(std::move(item));
+                pushed = true;
+            }
+            waiter.async->wake();
+        }
+    }
+
+    // Unlink the waiter if it is still parked, and push the item into the
+    // slot it was granted, if any.
+    template<typename T>
+    static bool finish_push(AsyncQueue<T>& queue, PushWaiter<T>& waiter, T& item) {
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        if (!queue.unpark(waiter)) {
+            return false;
+        }
+        queue.deliver(std::move(item));
+        return true;
+    }
+};
+
+template<typename R, typename = void>
+struct has_stop_token : std::false_type {};
+
+template<typename R>
+struct has_stop_token<R, std::void_t<decltype(std::declval<const R&>().get_stop_token())>>
+    : std::true_type {};
+
+// Shared by the operation states: completion runs once both start() has
+// finished and the operation was claimed (served, closed or stopped), so
+// the receiver never races with start().
+template<typename Receiver>
+class Operation : Work {
+protected:
+    using Scheduler = std::decay_t<decltype(std::declval<const Receiver&>().get_scheduler())>;
+
+    struct OnStop {
+        Operation* op;
+
+        void operator()() const {
+            if (op->claim_for_stop()) {
+                op->stopped_ = true;
+                op->release();
+            }
+        }
+    };
+
+    Receiver receiver_;
+    Scheduler scheduler_;
+    std::atomic<int> pending_{2};  // start() and the claim each drop one
+    bool stopped_ = false;
+    std::optional<StopCallback<OnStop>> on_stop_;
+
+    explicit Operation(Receiver receiver)
+        : receiver_(std::move(receiver)), scheduler_(receiver_.get_scheduler()) {
+        execute = &Operation::run;
+    }
+
+    ~Operation() = default;
+
+    // Win the operation for a stop request.
+    virtual bool claim_for_stop() = 0;
+    // On the scheduler: unpark, collect the result, call the receiver.
+    virtual void complete() = 0;
+
+    // End of start(), once the operation is parked.
+    void started() {
+        if constexpr (has_stop_token<Receiver>::value) {
+            on_stop_.emplace(receiver_.get_stop_token(), OnStop{this});
+        }
+        release();
+    }
+
+    void release() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            scheduler_.post(*this);
+        }
+    }
+
+    template<typename Value>
+    void finish(Value&& value) {
+        Receiver receiver = std::move(receiver_);
+        if (stopped_) {
+            receiver.set_stopped();
+        } else {
+            receiver.set_value(std::forward<Value>(value));
+        }
+    }
+
+private:
+    static void run(Work* work) {
+        auto* op = static_cast<Operation*>(work);
+        op->on_stop_.reset();
+        op->complete();
+    }
+
+public:
+    Operation(const Operation&) = delete;
+    Operation& operator=(const Operation&) = delete;
+};
+
+} // namespace detail
+
+template<typename T, typename Receiver>
+class PopOperation : detail::Operation<Receiver>, detail::AsyncWaiter {
+    AsyncQueue<T>& queue_;
+    detail::Async::PopWaiter<T> waiter_;
+    std::atomic<bool> claimed_{false};
+
+    bool claim() override {
+        return !claimed_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    void wake() override {
+        this->release();
+    }
+
+    bool claim_for_stop() override {
+        return claim();
+    }
+
+    void complete() override {
+        this->finish(detail::Async::unpark(queue_, waiter_));
+    }
+
+public:
+    PopOperation(AsyncQueue<T>& queue, Receiver receiver)
+        : detail::Operation<Receiver>(std::move(receiver)), queue_(queue) {
+        waiter_.async = this;
+    }
+
+    void start() {
+        detail::Async::pop_or_park(queue_, waiter_);
+        this->started();
+    }
+};
+
+template<typename T, typename Receiver>
+class PushOperation : detail::Operation<Receiver>, detail::AsyncWaiter {
+    AsyncQueue<T>& queue_;
+    T item_;
+    detail::Async::PushWaiter<T> waiter_;
+    std::atomic<bool> claimed_{false};
+    bool pushed_ = false;
+
+    bool claim() override {
+        return !claimed_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    void wake() override {
+        this->release();
+    }
+
+    bool claim_for_stop() override {
+        return claim();
+    }
+
+    void complete() override {
+        bool pushed = detail::Async::finish_push(queue_, waiter_, item_) || pushed_;
+        this->finish(pushed);
+    }
+
+public:
+    PushOperation(AsyncQueue<T>& queue, T item, int priority, Receiver receiver)
+        : detail::Operation<Receiver>(std::move(receiver)), queue_(queue),
+          item_(std::move(item)) {
+        waiter_.priority = priority;
+        waiter_.async = this;
+    }
+
+    void start() {
+        detail::Async::push_or_park(queue_, waiter_, item_, pushed_);
+        this->started();
+    }
+};
+
+// Pops from whichever of N queues (of one item type) has an item first.
+// Branches share one claim, so exactly one queue gives up an item.
+template<typename T, size_t N, typename Receiver>
+class WhenAnyOperation : detail::Operation<Receiver> {
+    static constexpr size_t stopped = N;
+    static constexpr size_t none = N + 1;
+
+    struct Branch : detail::AsyncWaiter {
+        WhenAnyOperation* op = nullptr;
+        size_t index = 0;
+        AsyncQueue<T>* queue = nullptr;
+        detail::Async::PopWaiter<T> waiter;
+
+        bool claim() override {
+            return op->claim(index);
+        }
+
+        void wake() override {
+            op->release();
+        }
+    };
+
+    std::array<Branch, N> branches_;
+    std::atomic<size_t> winner_{none};
+
+    bool claim(size_t index) {
+        size_t expected = none;
+        return winner_.compare_exchange_strong(expected, index, std::memory_order_acq_rel);
+    }
+
+    bool claim_for_stop() override {
+        return claim(stopped);
+    }
+
+    void complete() override {
+        size_t winner = winner_.load(std::memory_order_acquire);
+        std::optional<T> item;
+        for (Branch& branch : branches_) {
+            auto got = detail::Async::unpark(*branch.queue, branch.waiter);
+            if (branch.index == winner) {
+                item = std::move(got);
+            }
+        }
+        this->finish(std::make_pair(winner, std::move(item)));
+    }
+
+public:
+    WhenAnyOperation(const std::array<AsyncQueue<T>*, N>& queues, Receiver receiver)
+        : detail::Operation<Receiver>(std::move(receiver)) {
+        for (size_t i = 0; i < N; ++i) {
+            branches_[i].op = this;
+            branches_[i].index = i;
+            branches_[i].queue = queues[i];
+            branches_[i].waiter.async = &branches_[i];
+        }
+    }
+
+    void start() {
+        for (Branch& branch : branches_) {
+            if (winner_.load(std::memory_order_acquire) != none) {
+                break;
+            }
+            detail::Async::pop_or_park(*branch.queue, branch.waiter);
+        }
+        this->started();
+    }
+};
+
+// Completes with the next item, or nullopt once the queue is closed and
+// drained.
+template<typename T>
+class PopSender {
+    AsyncQueue<T>* queue_;
+
+public:
+    using value_type = std::optional<T>;
+
+    explicit PopSender(AsyncQueue<T>& queue) : queue_(&queue) {}
+
+    AsyncQueue<T>& queue() const {
+        return *queue_;
+    }
+
+    template<typename Receiver>
+    PopOperation<T, Receiver> connect(Receiver receiver) const {
+        return PopOperation<T, Receiver>(*queue_, std::move(receiver));
+    }
+};
+
+// Completes with true once the item is queued, or false if the queue is
+// closed first.
+template<typename T>
+class PushSender {
+    AsyncQueue<T>* queue_;
+    T item_;
+    int priority_;
+
+public:
+    using value_type = bool;
+
+    PushSender(AsyncQueue<T>& queue, T item, int priority)
+        : queue_(&queue), item_(std::move(item)), priority_(priority) {}
+
+    template<typename Receiver>
+    PushOperation<T, Receiver> connect(Receiver receiver) && {
+        return PushOperation<T, Receiver>(*queue_, std::move(item_), priority_,
+                                          std::move(receiver));
+    }
+};
+
+// Completes with the index of the queue that delivered first and its item
+// (nullopt if that queue was closed and drained).
+template<typename T, size_t N>
+class WhenAnySender {
+    std::array<AsyncQueue<T>*, N> queues_;
+
+public:
+    using value_type = std::pair<size_t, std::optional<T>>;
+
+    explicit WhenAnySender(const std::array<AsyncQueue<T>*, N>& queues) : queues_(queues) {}
+
+    template<typename Receiver>
+    WhenAnyOperation<T, N, Receiver> connect(Receiver receiver) const {
+        return WhenAnyOperation<T, N, Receiver>(queues_, std::move(receiver));
+    }
+};
+
+template<typename T>
+PopSender<T> async_pop(AsyncQueue<T>& queue) {
+    return PopSender<T>(queue);
+}
+
+template<typename T, typename U>
+PushSender<T> async_push(AsyncQueue<T>& queue, U&& item, int priority = 0) {
+    return PushSender<T>(queue, T(std::forward<U>(item)), priority);
+}
+
+template<typename T, typename... Rest>
+WhenAnySender<T, 1 + sizeof...(Rest)> when_any(const PopSender<T>& first,
+                                                const PopSender<Rest>&... rest) {
+    static_assert((std::is_same_v<T, Rest> && ...),
+                  "when_any needs queues of one item type");
+    return WhenAnySender<T, 1 + sizeof...(Rest)>({&first.queue(), &rest.queue()...});
+}
+
+template<typename Sender, typename Receiver>
+auto connect(Sender&& sender, Receiver receiver) {
+    return std::forward<Sender>(sender).connect(std::move(receiver));
+}
+
+// Start the sender and run a local RunLoop until it completes. Returns its
+// value, or nullopt if it was stopped.
+template<typename Sender>
+std::optional<typename std::decay_t<Sender>::value_type> sync_wait(Sender&& sender) {
+    using Value = typename std::decay_t<Sender>::value_type;
+
+    struct Receiver {
+        RunLoop* loop;
+        std::optional<Value>* result;
+
+        void set_value(Value value) {
+            result->emplace(std::move(value));
+            loop->finish();
+        }
+
+        void set_stopped() {
+            loop->finish();
+        }
+
+        RunLoop::Scheduler get_scheduler() const {
+            return loop->get_scheduler();
+        }
+    };
+
+    RunLoop loop;
+    std::optional<Value> result;
+    auto op = connect(std::forward<Sender>(sender), Receiver{&loop, &result});
+    op.start();
+    loop.run();
+    return result;
+}
+
+} // namespace async_queue
@@ -1,34 +1,1113 @@
 #pragma once
-#include <queue>
+#include "async_queue/codel.hpp"
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <optional>
 #include <condition_variable>
 #include <chrono>
 #include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <iterator>
+#include <utility>
+#include <vector>
 
 namespace async_queue {
 
 template<typename T, typename... Extensions>
 class AsyncQueue;
 
+namespace detail {
+
+// Intrusive FIFO of waiters. Nodes live on the stacks of the blocked
+// threads, so parking never allocates. Guarded by the owning queue's mutex.
+template<typename Node>
+class WaiterList {
+    Node* head_ = nullptr;
+    Node* tail_ = nullptr;
+
+public:
+    bool empty() const { return head_ == nullptr; }
+    Node* front() const { return head_; }
+
+    void push_back(Node* node) {
+        node->prev = tail_;
+        node->next = nullptr;
+        (tail_ ? tail_->next : head_) = node;
+        tail_ = node;
+        node->linked = true;
+    }
+
+    // Insert before pos; a null pos appends.
+    void insert_before(Node* pos, Node* node) {
+        if (!pos) {
+            push_back(node);
+            return;
+        }
+        node->prev = pos->prev;
+        node->next = pos;
+        (pos->prev ? pos->prev->next : head_) = node;
+        pos->prev = node;
+        node->linked = true;
+    }
+
+    void erase(Node* node) {
+        (node->prev ? node->prev->next : head_) = node->next;
+        (node->next ? node->next->prev : tail_) = node->prev;
+        node->prev = node->next = nullptr;
+        node->linked = false;
+    }
+
+    Node* pop_front() {
+        Node* node = head_;
+        if (node) {
+            erase(node);
+        }
+        return node;
+    }
+
+    template<typename F>
+    void for_each(F f) const {
+        for (Node* node = head_; node; node = node->next) {
+            f(*node);
+        }
+    }
+};
+
+// A parked pop or push that belongs to an asynchronous operation rather
+// than a blocked thread (see async.hpp). The queue calls both with its
+// mutex held; neither may block or call back into the queue.
+struct AsyncWaiter {
+    // Asked before an item or slot is handed over or a close is reported.
+    // False means the operation already completed another way (it was
+    // stopped, or another branch of a when_any won), and the queue skips it.
+    virtual bool claim() = 0;
+    // The claimed waiter was served or the queue closed.
+    virtual void wake() = 0;
+
+protected:
+    ~AsyncWaiter() = default;
+};
+
+struct MultiPush;
+struct Checkpoint;
+struct Async;
+
+} // namespace detail
+
+// Outcome of the *_status operations.
+enum class QueueStatus {
+    ok,       // the item was pushed or popped
+    timeout,  // the wait ran out
+    closed,   // closed (and, for pops, drained)
+    full,     // non-blocking push found no room
+    empty,    // non-blocking pop found nothing
+};
+
+// Load figures from AsyncQueue::stats(), read without locking.
+struct QueueStats {
+    size_t depth = 0;                   // pending items
+    std::chrono::nanoseconds dwell{0};  // moving average of time spent queued
+    uint64_t dropped = 0;               // items shed by CoDel
+};
+
+// Service-mode metrics from AsyncQueue::lifo_stats().
+struct LifoStats {
+    bool lifo = false;                      // currently serving newest first
+    std::chrono::nanoseconds fifo_time{0};  // time spent in each mode since
+    std::chrono::nanoseconds lifo_time{0};  // set_adaptive_lifo()
+    uint64_t switches = 0;                  // mode changes
+};
+
+// Told when a queue stores an item or closes, e.g. to wake an event loop
+// that drains the queue (see io_uring_notifier.hpp). Items handed straight
+// to a parked consumer are not reported. notify() runs with the queue's
+// mutex held; it must not block or call back into the queue.
+class ReadinessNotifier {
+public:
+    virtual void notify() = 0;
+
+protected:
+    ~ReadinessNotifier() = default;
+};
+
+// How blocked producers get capacity that frees up.
+//
+// barging: a freed slot wakes a producer, but any thread that gets to the
+//          mutex first may take it. Highest throughput, unbounded overtaking.
+// fifo:    freed slots are granted to parked producers strictly in arrival
+//          order and reserved until the grantee runs, so nobody overtakes.
+//
+// Producers pushing with an admission priority above the default always
+// park in priority order, ahead of barging producers. Consumers are always served in arrival order: a push hands
+// its item to the longest-parked consumer.
+enum class Fairness {
+    barging,
+    fifo,
+};
+
+// Identifies an item pushed with push_tracked() so it can be cancelled while
+// still pending. Handles are never reused within a queue.
+struct ItemHandle {
+    uint64_t seq = std::numeric_limits<uint64_t>::max();
+
+    bool valid() const { return seq != std::numeric_limits<uint64_t>::max(); }
+};
+
 // Primary template - the base AsyncQueue without extensions
 template<typename T>
 class AsyncQueue<T> {
 protected:
+    // Pending items in FIFO order. Items taken from the middle (pop_if,
+    // cancel, remove_if) are tombstoned instead of erased so storage never
+    // shifts; consumers skip dead entries at the front, and the rest are
+    // compacted away in batches once they outnumber the live ones.
+    struct Entry {
+        T item;
+        uint64_t seq;
+        bool live;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    // A consumer blocked in pop()/try_pop(). push() moves the item straight
+    // into the longest-parked consumer's slot and wakes that thread alone,
+    // so the item never touches queue_ and no other thread can steal it.
+    struct PopWaiter {
+        std::condition_variable cv;
+        std::optional<T> item;
+        uint64_t seq = 0;                      // of item, once handed over
+        bool holds = false;                    // a consume() batch keeps its slot
+        detail::AsyncWaiter* async = nullptr;  // woken instead of cv if set
+        PopWaiter* prev = nullptr;
+        PopWaiter* next = nullptr;
+        bool linked = false;
+    };
+
+    // A parked producer. Parked producers are ordered by admission
+    // priority, then arrival; the head is granted the next free slot, which
+    // stays reserved until it runs.
+    struct PushWaiter {
+        std::condition_variable cv;
+        int priority = 0;
+        bool granted = false;
+        detail::AsyncWaiter* async = nullptr;  // woken instead of cv if set
+        PushWaiter* prev = nullptr;
+        PushWaiter* next = nullptr;
+        bool linked = false;
+    };
+
     mutable std::mutex mutex_;
     std::condition_variable cv_;
-    std::queue<T> queue_;
+    std::deque<Entry> queue_;
+    size_t size_ = 0;            // live entries in queue_
+    size_t dead_ = 0;            // tombstones in queue_
+    uint64_t next_seq_ = 0;
+    size_t selective_waiters_ = 0;
+    uint64_t requeues_ = 0;      // bumped when release_batch() stores older items
+    // Non-empty only while nothing is stored: push() serves these first.
+    detail::WaiterList<PopWaiter> parked_consumers_;
+    detail::WaiterList<PushWaiter> parked_producers_;
+    size_t granted_ = 0;         // slots reserved for woken producers
+    size_t held_ = 0;            // slots kept for items out in consume() batches
+    bool discard_held_ = false;  // emptied by abort(): batches given back are cancelled
+    size_t reserved_ = 0;        // slots only high priorities may fill
+    int reserved_min_priority_ = 0;
+    size_t room_watchers_ = 0;   // push_all() calls waiting on cv_ for room
+    size_t barging_waiters_ = 0; // producers waiting on cv_ for room
+    std::condition_variable drained_cv_;
+    size_t drain_waiters_ = 0;   // close_and_drain() calls waiting for empty
     bool closed_ = false;
+    // Lock-free mirrors for stats(); written only with mutex_ held.
+    std::atomic<size_t> depth_{0};
+    std::atomic<int64_t> dwell_ns_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::optional<detail::CoDel> codel_;  // set by set_codel()
+    std::function<void(T)> drop_handler_;
+    std::vector<T> shed_;  // dropped items for drop_handler_, see run_drop_handler()
+    ReadinessNotifier* notifier_ = nullptr;  // set by set_notifier()
+    // Adaptive LIFO (set_adaptive_lifo); off while lifo_threshold_ is empty.
+    std::optional<std::chrono::nanoseconds> lifo_threshold_;
+    bool lifo_ = false;
+    std::chrono::steady_clock::time_point mode_since_{};
+    std::chrono::nanoseconds fifo_time_{0};
+    std::chrono::nanoseconds lifo_time_{0};
+    uint64_t mode_switches_ = 0;
     const size_t capacity_;
+    const Fairness fairness_;
 
     // Protected interface for extensions
     virtual void on_push([[maybe_unused]] const T& item) {}
     virtual void on_pop([[maybe_unused]] const T& item) {}
     virtual void on_close() {}
+    virtual void on_cancel([[maybe_unused]] const T& item) {}
+    // abort() removed every pending item at once.
+    virtual void on_clear() {}
+    // A consume() range put back an item it popped but never handed out.
+    // Unlike on_push, the item may land anywhere among the pending ones: it
+    // returns to the position its seq gives it.
+    virtual void on_requeue(const T& item, [[maybe_unused]] uint64_t seq) {
+        on_push(item);
+    }
+
+    static constexpr size_t compact_threshold_ = 64;
+
+    // Helpers for the queue and its extensions; mutex_ must be held.
+
+    // Capacity was freed: grant it to parked producers, then let barging
+    // producers and multi-queue pushes compete for what is left.
+    void notify_waiters() {
+        grant_slots();
+        if (fairness_ == Fairness::fifo && room_watchers_ == 0) {
+            return;
+        }
+        // Producers share cv_ with selective waiters and multi-queue
+        // pushes, so a single wakeup could be swallowed by one of those.
+        if (selective_waiters_ > 0 || room_watchers_ > 0) {
+            cv_.notify_all();
+        } else {
+            cv_.notify_one();
+        }
+    }
+
+    // How many items a push at this admission priority may fill the queue
+    // to. Slots set aside by reserve_capacity() only admit high enough
+    // priorities.
+    size_t limit_for(int priority) const {
+        if (priority < reserved_min_priority_) {
+            return capacity_ > reserved_ ? capacity_ - reserved_ : 0;
+        }
+        return capacity_;
+    }
+
+    // Whether a push at this admission priority fits.
+    bool has_room(int priority, size_t count = 1) const {
+        size_t limit = limit_for(priority);
+        size_t used = size_ + granted_ + held_;
+        return used < limit && limit - used >= count;
+    }
+
+    // Whether an arriving producer may take a free slot without queueing
+    // behind parked producers.
+    bool may_enter(int priority) const {
+        if (!has_room(priority)) {
+            return false;
+        }
+        return fairness_ == Fairness::barging || parked_producers_.empty() ||
+               parked_producers_.front()->priority < priority;
+    }
+
+    // Barging producers at or below the default priority wait on cv_;
+    // everyone else parks in priority order, to be granted slots first.
+    bool parks(int priority) const {
+        return fairness_ == Fairness::fifo || priority > 0;
+    }
+
+    void park(PushWaiter* waiter) {
+        PushWaiter* pos = parked_producers_.front();
+        while (pos && pos->priority >= waiter->priority) {
+            pos = pos->next;
+        }
+        parked_producers_.insert_before(pos, waiter);
+    }
+
+    void grant_slots() {
+        while (!parked_producers_.empty() &&
+               has_room(parked_producers_.front()->priority)) {
+            PushWaiter* waiter = parked_producers_.pop_front();
+            if (!claims(*waiter)) {
+                continue;
+            }
+            waiter->granted = true;
+            ++granted_;
+            wake(*waiter);
+        }
+    }
+
+    // Whether a parked waiter still wants what it is about to be given.
+    template<typename Waiter>
+    static bool claims(Waiter& waiter) {
+        return !waiter.async || waiter.async->claim();
+    }
+
+    template<typename Waiter>
+    static void wake(Waiter& waiter) {
+        if (waiter.async) {
+            waiter.async->wake();
+        } else {
+            waiter.cv.notify_one();
+        }
+    }
+
+    // The longest-parked consumer still accepting an item, or null.
+    PopWaiter* next_consumer() {
+        while (PopWaiter* waiter = parked_consumers_.pop_front()) {
+            if (claims(*waiter)) {
+                return waiter;
+            }
+        }
+        return nullptr;
+    }
+
+    // Wait until this producer may add an item. Returns false if the queue
+    // is closed first.
+    bool wait_for_room(std::unique_lock<std::mutex>& lock, int priority) {
+        if (closed_) {
+            return false;
+        }
+        if (may_enter(priority)) {
+            return true;
+        }
+        if (!parks(priority)) {
+            ++barging_waiters_;
+            cv_.wait(lock, [&] {
+                return has_room(priority) || closed_;
+            });
+            --barging_waiters_;
+            return !closed_;
+        }
+        PushWaiter waiter;
+        waiter.priority = priority;
+        park(&waiter);
+        waiter.cv.wait(lock, [&] {
+            return waiter.granted || closed_;
+        });
+        return unpark(waiter);
+    }
+
+    template<typename Rep, typename Period>
+    bool wait_for_room(std::unique_lock<std::mutex>& lock, int priority,
+                       const std::chrono::duration<Rep, Period>& timeout) {
+        if (closed_) {
+            return false;
+        }
+        if (may_enter(priority)) {
+            return true;
+        }
+        if (!parks(priority)) {
+            ++barging_waiters_;
+            bool room = cv_.wait_for(lock, timeout, [&] {
+                return has_room(priority) || closed_;
+            });
+            --barging_waiters_;
+            return room && !closed_;
+        }
+        PushWaiter waiter;
+        waiter.priority = priority;
+        park(&waiter);
+        waiter.cv.wait_for(lock, timeout, [&] {
+            return waiter.granted || closed_;
+        });
+        return unpark(waiter);
+    }
+
+    bool unpark(PushWaiter& waiter) {
+        if (waiter.linked) {
+            parked_producers_.erase(&waiter);
+        }
+        if (!waiter.granted) {
+            return false;
+        }
+        --granted_;
+        return !closed_;
+    }
+
+    template<typename U>
+    void enqueue(U&& item) {
+        queue_.push_back(Entry{T(std::forward<U>(item)), next_seq_++, true,
+                               std::chrono::steady_clock::now()});
+        ++size_;
+        publish_depth();
+        on_push(queue_.back().item);
+        if (notifier_) {
+            notifier_->notify();
+        }
+    }
+
+    // Hand the item to the longest-parked consumer, or store it if none is
+    // waiting. Returns the item's sequence number.
+    template<typename U>
+    uint64_t deliver(U&& item) {
+        if (PopWaiter* waiter = next_consumer()) {
+            waiter->item.emplace(std::forward<U>(item));
+            waiter->seq = next_seq_;
+            if (waiter->holds) {
+                ++held_;
+            }
+            on_push(*waiter->item);
+            on_pop(*waiter->item);
+            wake(*waiter);
+            record_dwell(0);
+            // A granted slot may have gone unused; barging producers
+            // waiting on cv_ can have it.
+            notify_waiters();
+            return next_seq_++;
+        }
+
+        enqueue(std::forward<U>(item));
+        // Plain consumers are never blocked while items are stored; only
+        // selective waiters could want this one.
+        if (selective_waiters_ > 0) {
+            cv_.notify_all();
+        }
+        return queue_.back().seq;
+    }
+
+    // Remove the next item for a plain pop (after CoDel and adaptive LIFO
+    // had their say) along with its seq and enqueue time. The caller
+    // notifies waiters. Requires size_ > 0.
+    Entry pop_one() {
+        if (codel_) {
+            shed_stale();
+        }
+        bool from_back = lifo_threshold_ && serve_lifo();
+        skip_dead_front();
+        while (from_back && !queue_.back().live) {
+            queue_.pop_back();
+            --dead_;
+        }
+        const Entry& next = from_back ? queue_.back() : queue_.front();
+        uint64_t seq = next.seq;
+        auto enqueued = next.enqueued;
+        T item = from_back ? take_back() : take_front();
+        on_pop(item);
+        return Entry{std::move(item), seq, true, enqueued};
+    }
+
+    // Requires size_ > 0.
+    T pop_stored() {
+        T item = std::move(pop_one().item);
+        notify_waiters();
+        return item;
+    }
+
+    // Capacity for count items was freed at once.
+    void notify_freed(size_t count) {
+        if (count <= 1) {
+            notify_waiters();
+            return;
+        }
+        grant_slots();
+        if (fairness_ == Fairness::barging || room_watchers_ > 0) {
+            cv_.notify_all();
+        }
+    }
+
+    // Pop up to max stored items, passing each entry to emit. With hold,
+    // their slots stay taken (see release_batch()). Requires size_ > 0.
+    template<typename Emit>
+    size_t pop_stored_bulk(size_t max, Emit& emit, bool hold = false) {
+        size_t count = 0;
+        while (count < max && size_ > 0) {
+            emit(pop_one());
+            ++count;
+        }
+        if (hold) {
+            held_ += count;
+        } else {
+            notify_freed(count);
+        }
+        return count;
+    }
+
+    // An item a parked bulk pop received by handoff, as an entry that can
+    // be requeued: it keeps the seq deliver() gave it, and counts as
+    // enqueued now.
+    static Entry handed_off(T&& item, uint64_t seq) {
+        return Entry{std::move(item), seq, true, std::chrono::steady_clock::now()};
+    }
+
+    // Bulk pop body: take what is stored, or park for a single handoff.
+    template<typename Emit>
+    size_t pop_bulk_wait(std::unique_lock<std::mutex>& lock, size_t max, Emit& emit,
+                         bool hold = false) {
+        if (max == 0) {
+            return 0;
+        }
+        if (size_ > 0) {
+            return pop_stored_bulk(max, emit, hold);
+        }
+        uint64_t seq = 0;
+        auto item = pop_wait(lock, &seq, hold);
+        if (!item) {
+            return 0;
+        }
+        emit(handed_off(std::move(*item), seq));
+        return 1;
+    }
+
+    template<typename Emit, typename Rep, typename Period>
+    size_t pop_bulk_wait(std::unique_lock<std::mutex>& lock, size_t max, Emit& emit,
+                         const std::chrono::duration<Rep, Period>& timeout) {
+        if (max == 0) {
+            return 0;
+        }
+        if (size_ > 0) {
+            return pop_stored_bulk(max, emit);
+        }
+        uint64_t seq = 0;
+        auto item = pop_wait(lock, timeout, &seq);
+        if (!item) {
+            return 0;
+        }
+        emit(handed_off(std::move(*item), seq));
+        return 1;
+    }
+
+    // Release the slots of a consume() batch. Entries from `from` on were
+    // never handed out and go back in seq order: first to parked consumers,
+    // the rest into their original position among the pending items. They
+    // still have their slots, so this never overfills the queue. Once
+    // abort() has run they are cancelled instead.
+    void release_batch(std::vector<Entry>& entries, size_t from) {
+        held_ -= entries.size();
+        size_t freed = entries.size();
+        size_t stored = 0;
+        for (size_t i = from; i < entries.size(); ++i) {
+            if (discard_held_) {
+                on_cancel(entries[i].item);
+                continue;
+            }
+            if (PopWaiter* waiter = next_consumer()) {
+                waiter->item.emplace(std::move(entries[i].item));
+                waiter->seq = entries[i].seq;
+                if (waiter->holds) {
+                    ++held_;
+                    --freed;
+                }
+                wake(*waiter);
+                continue;
+            }
+            auto pos = std::lower_bound(queue_.begin(), queue_.end(), entries[i].seq,
+                [](const Entry& e, uint64_t s) { return e.seq < s; });
+            auto it = queue_.insert(pos, std::move(entries[i]));
+            ++size_;
+            ++requeues_;
+            ++stored;
+            --freed;
+            on_requeue(it->item, it->seq);
+        }
+        if (stored > 0) {
+            publish_depth();
+            if (notifier_) {
+                notifier_->notify();
+            }
+            if (selective_waiters_ > 0) {
+                cv_.notify_all();
+            }
+        }
+        if (freed > 0) {
+            notify_freed(freed);
+        }
+        if (size_ == 0 && held_ == 0 && drain_waiters_ > 0) {
+            drained_cv_.notify_all();
+        }
+    }
+
+    // CoDel: drop items from the front while their queueing delay says the
+    // queue is standing. Always leaves at least one item.
+    void shed_stale() {
+        auto now = std::chrono::steady_clock::now();
+        for (;;) {
+            skip_dead_front();
+            Entry& front = queue_.front();
+            if (!codel_->should_drop(front.enqueued, now, size_)) {
+                return;
+            }
+            T item = std::move(front.item);
+            kill(front);
+            on_cancel(item);
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+            if (drop_handler_) {
+                shed_.push_back(std::move(item));
+            }
+        }
+    }
+
+    // Pass what shed_stale() dropped to the drop handler, unlocking first so
+    // the handler may block or use this queue. Every caller of pop_one()
+    // runs this before returning, so shed_ is empty whenever mutex_ is free.
+    void run_drop_handler(std::unique_lock<std::mutex>& lock) {
+        if (shed_.empty()) {
+            return;
+        }
+        std::vector<T> dropped;
+        dropped.swap(shed_);
+        auto handler = drop_handler_;
+        lock.unlock();
+        for (T& item : dropped) {
+            handler(std::move(item));
+        }
+    }
+
+    // Adaptive LIFO: serve newest first while the oldest item has waited
+    // past the threshold, and go back to FIFO once the backlog is down to
+    // a single item. Requires size_ > 0.
+    bool serve_lifo() {
+        auto now = std::chrono::steady_clock::now();
+        skip_dead_front();
+        bool lifo = size_ > 1 && now - queue_.front().enqueued > *lifo_threshold_;
+        if (lifo != lifo_) {
+            account_mode(now);
+            lifo_ = lifo;
+            ++mode_switches_;
+        }
+        return lifo_;
+    }
+
+    // Charge the time since the last mode change to the current mode.
+    void account_mode(std::chrono::steady_clock::time_point now) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mode_since_);
+        (lifo_ ? lifo_time_ : fifo_time_) += elapsed;
+        mode_since_ = now;
+    }
+
+    // Take a stored item or park until one is handed over. Returns nullopt
+    // once the queue is closed and drained.
+    // seq, if given, receives the seq of a handed-off item. With hold, a
+    // handed-off item keeps its slot (see release_batch()).
+    std::optional<T> pop_wait(std::unique_lock<std::mutex>& lock, uint64_t* seq = nullptr,
+                              bool hold = false) {
+        if (size_ > 0) {
+            return pop_stored();
+        }
+        if (closed_) {
+            return std::nullopt;
+        }
+
+        PopWaiter waiter;
+        waiter.holds = hold;
+        parked_consumers_.push_back(&waiter);
+        waiter.cv.wait(lock, [&] {
+            return waiter.item.has_value() || closed_;
+        });
+        return unpark(waiter, seq);
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<T> pop_wait(std::unique_lock<std::mutex>& lock,
+                              const std::chrono::duration<Rep, Period>& timeout,
+                              uint64_t* seq = nullptr) {
+        if (size_ > 0) {
+            return pop_stored();
+        }
+        if (closed_) {
+            return std::nullopt;
+        }
+
+        PopWaiter waiter;
+        parked_consumers_.push_back(&waiter);
+        waiter.cv.wait_for(lock, timeout, [&] {
+            return waiter.item.has_value() || closed_;
+        });
+        return unpark(waiter, seq);
+    }
+
+    std::optional<T> unpark(PopWaiter& waiter, uint64_t* seq = nullptr) {
+        if (waiter.linked) {
+            parked_consumers_.erase(&waiter);
+        }
+        if (seq) {
+            *seq = waiter.seq;
+        }
+        return std::move(waiter.item);
+    }
+
+    void publish_depth() {
+        depth_.store(size_, std::memory_order_relaxed);
+    }
+
+    // Fold one item's time in the queue into the moving average (1/8 weight).
+    void record_dwell(int64_t ns) {
+        int64_t average = dwell_ns_.load(std::memory_order_relaxed);
+        dwell_ns_.store(average + (ns - average) / 8, std::memory_order_relaxed);
+    }
+
+    void kill(Entry& entry) {
+        entry.live = false;
+        --size_;
+        ++dead_;
+        publish_depth();
+        if (size_ == 0 && drain_waiters_ > 0) {
+            drained_cv_.notify_all();
+        }
+    }
+
+    QueueStatus finish_pop(std::optional<T>&& item, T& out, QueueStatus miss) {
+        if (!item) {
+            return miss;
+        }
+        out = std::move(*item);
+        return QueueStatus::ok;
+    }
+
+    // Mark the queue closed and wake each blocked thread once. Returns
+    // false, waking nobody, if it was already closed.
+    bool close_locked() {
+        if (closed_) {
+            return false;
+        }
+        closed_ = true;
+        on_close();
+        if (notifier_) {
+            notifier_->notify();
+        }
+        // Woken waiters stay linked and unpark themselves.
+        parked_consumers_.for_each([](PopWaiter& waiter) {
+            if (claims(waiter)) {
+                wake(waiter);
+            }
+        });
+        parked_producers_.for_each([](PushWaiter& waiter) {
+            if (claims(waiter)) {
+                wake(waiter);
+            }
+        });
+        cv_.notify_all();
+        return true;
+    }
+
+    // Some thread is parked in, was granted a slot by, or holds a consume()
+    // batch from this queue.
+    bool has_waiters() const {
+        return !parked_consumers_.empty() || !parked_producers_.empty() || granted_ > 0 ||
+               held_ > 0 ||
+               selective_waiters_ > 0 || room_watchers_ > 0 || barging_waiters_ > 0 ||
+               drain_waiters_ > 0;
+    }
+
+    void skip_dead_front() {
+        while (!queue_.empty() && !queue_.front().live) {
+            queue_.pop_front();
+            --dead_;
+        }
+    }
+
+    void maybe_compact() {
+        if (dead_ > compact_threshold_ && dead_ > size_) {
+            queue_.erase(std::remove_if(queue_.begin(), queue_.end(),
+                [](const Entry& e) { return !e.live; }), queue_.end());
+            dead_ = 0;
+        }
+    }
+
+    T take(Entry& entry) {
+        record_dwell(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - entry.enqueued).count());
+        T item = std::move(entry.item);
+        kill(entry);
+        skip_dead_front();
+        return item;
+    }
+
+    // Requires size_ > 0.
+    T take_back() {
+        while (!queue_.back().live) {
+            queue_.pop_back();
+            --dead_;
+        }
+        T item = take(queue_.back());
+        if (!queue_.empty()) {
+            queue_.pop_back();
+            --dead_;
+        }
+        return item;
+    }
+
+    // Requires size_ > 0.
+    T take_front() {
+        skip_dead_front();
+        return take(queue_.front());
+    }
+
+    // Tombstone a pending entry and release its payload now.
+    void discard(Entry& entry) {
+        T item = std::move(entry.item);
+        kill(entry);
+        on_cancel(item);
+    }
+
+    // Live entry with the given sequence number, or nullptr.
+    Entry* find_seq(uint64_t seq) {
+        if (queue_.empty() || seq < queue_.front().seq) {
+            return nullptr;
+        }
+        // Entries are sorted by seq; without holes the position is direct.
+        uint64_t offset = seq - queue_.front().seq;
+        if (offset < queue_.size() && queue_[offset].seq == seq) {
+            return queue_[offset].live ? &queue_[offset] : nullptr;
+        }
+        auto it = std::lower_bound(queue_.begin(), queue_.end(), seq,
+            [](const Entry& e, uint64_t s) { return e.seq < s; });
+        if (it == queue_.end() || it->seq != seq || !it->live) {
+            return nullptr;
+        }
+        return &*it;
+    }
+
+    // First live entry with seq >= from matching pred, or nullptr.
+    template<typename Pred>
+    Entry* find_first_if(Pred& pred, uint64_t from = 0) {
+        auto it = queue_.begin();
+        if (!queue_.empty() && from > queue_.front().seq) {
+            it = std::lower_bound(queue_.begin(), queue_.end(), from,
+                [](const Entry& e, uint64_t s) { return e.seq < s; });
+        }
+        for (; it != queue_.end(); ++it) {
+            if (it->live && pred(static_cast<const T&>(it->item))) {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    void rescan_after_requeue(uint64_t& scanned, uint64_t& requeues) const {
+        if (requeues != requeues_) {
+            requeues = requeues_;
+            scanned = 0;
+        }
+    }
+
+    // Wait until pred returns an entry or the queue is closed. Each wakeup
+    // only rescans entries pushed since the previous scan, unless
+    // release_batch() brought back older ones.
+    template<typename Pred>
+    Entry* wait_match(std::unique_lock<std::mutex>& lock, Pred& pred) {
+        Entry* match = nullptr;
+        uint64_t scanned = 0;
+        uint64_t requeues = requeues_;
+        ++selective_waiters_;
+        cv_.wait(lock, [&] {
+            rescan_after_requeue(scanned, requeues);
+            match = find_first_if(pred, scanned);
+            scanned = next_seq_;
+            return match != nullptr || closed_;
+        });
+        --selective_waiters_;
+        return match;
+    }
+
+    template<typename Pred, typename Rep, typename Period>
+    Entry* wait_match_for(std::unique_lock<std::mutex>& lock, Pred& pred,
+                          const std::chrono::duration<Rep, Period>& timeout) {
+        Entry* match = nullptr;
+        uint64_t scanned = 0;
+        uint64_t requeues = requeues_;
+        ++selective_waiters_;
+        cv_.wait_for(lock, timeout, [&] {
+            rescan_after_requeue(scanned, requeues);
+            match = find_first_if(pred, scanned);
+            scanned = next_seq_;
+            return match != nullptr || closed_;
+        });
+        --selective_waiters_;
+        return match;
+    }
+
+    friend struct detail::MultiPush;
+    friend struct detail::Checkpoint;
+    friend struct detail::Async;
 
 public:
-    explicit AsyncQueue(size_t capacity = std::numeric_limits<size_t>::max())
-        : capacity_(capacity) {}
+    // Single-pass input range returned by consume(). Items are popped in
+    // batches into a local buffer, so the queue is locked once per batch
+    // rather than once per item. Iteration ends once the queue is closed
+    // and drained. The next batch is fetched when the iterator is compared
+    // to end(), never on increment, so adaptors such as views::take don't
+    // block past the last item they want. If iteration stops early, the
+    // items of the batch that were never dereferenced are put back into the
+    // queue in their original order. In a bounded queue a batch keeps its
+    // slots until the range fetches the next one or is destroyed, so
+    // putting items back never takes the queue past capacity.
+    class ConsumeRange {
+        AsyncQueue* queue_;
+        std::vector<Entry> buffer_;
+        size_t pos_ = 0;
+        size_t batch_;
+        bool taken_ = false;  // buffer_[pos_] was dereferenced
+
+        friend class AsyncQueue;
+        ConsumeRange(AsyncQueue& queue, size_t batch)
+            : queue_(&queue), batch_(batch > 0 ? batch : 1) {}
+
+        void refill() {
+            auto emit = [this](Entry&& entry) {
+                buffer_.push_back(std::move(entry));
+            };
+            std::unique_lock<std::mutex> lock(queue_->mutex_);
+            // Every item of the previous batch has been handed out.
+            queue_->release_batch(buffer_, buffer_.size());
+            buffer_.clear();
+            pos_ = 0;
+            queue_->pop_bulk_wait(lock, batch_, emit, true);
+            queue_->run_drop_handler(lock);
+        }
+
+        // Whether an item is available, fetching a batch if needed.
+        bool ready() {
+            if (pos_ == buffer_.size()) {
+                refill();
+            }
+            return pos_ < buffer_.size();
+        }
+
+        T& current() {
+            taken_ = true;
+            return buffer_[pos_].item;
+        }
+
+        void advance() {
+            ++pos_;
+            taken_ = false;
+        }
+
+        void give_back() {
+            size_t from = pos_ + (taken_ ? 1 : 0);
+            if (queue_ && !buffer_.empty()) {
+                std::lock_guard<std::mutex> lock(queue_->mutex_);
+                queue_->release_batch(buffer_, from);
+            }
+            buffer_.clear();
+            pos_ = 0;
+            taken_ = false;
+        }
+
+    public:
+        struct sentinel {};
+
+        class iterator {
+            ConsumeRange* range_ = nullptr;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+            iterator() = default;
+            explicit iterator(ConsumeRange* range) : range_(range) {}
+
+            // Blocks until the next item arrives or the queue is drained.
+            bool done() const {
+                return !range_->ready();
+            }
+
+            T& operator*() const { return range_->current(); }
+            T* operator->() const { return &range_->current(); }
+            iterator& operator++() {
+                range_->advance();
+                return *this;
+            }
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& it, sentinel) {
+                return it.done();
+            }
+            friend bool operator==(sentinel s, const iterator& it) { return it == s; }
+            friend bool operator!=(const iterator& it, sentinel s) { return !(it == s); }
+            friend bool operator!=(sentinel s, const iterator& it) { return !(it == s); }
+        };
+
+        ConsumeRange(ConsumeRange&& other) noexcept
+            : queue_(std::exchange(other.queue_, nullptr)),
+              buffer_(std::move(other.buffer_)),
+              pos_(other.pos_),
+              batch_(other.batch_),
+              taken_(other.taken_) {}
+
+        // The batch this range still holds goes back first.
+        ConsumeRange& operator=(ConsumeRange&& other) noexcept {
+            if (this != &other) {
+                give_back();
+                queue_ = std::exchange(other.queue_, nullptr);
+                buffer_ = std::move(other.buffer_);
+                pos_ = other.pos_;
+                batch_ = other.batch_;
+                taken_ = other.taken_;
+            }
+            return *this;
+        }
+
+        ~ConsumeRange() {
+            give_back();
+        }
+
+        iterator begin() {
+            return iterator(this);
+        }
+
+        sentinel end() {
+            return {};
+        }
+    };
+
+    // Items handed back by abort(), in FIFO order. Holds the queue's own
+    // storage, so taking it out of the queue is a single move.
+    class PendingItems {
+        std::deque<Entry> entries_;
+        size_t size_ = 0;
+
+        friend class AsyncQueue;
+        PendingItems(std::deque<Entry>&& entries, size_t size)
+            : entries_(std::move(entries)), size_(size) {}
+
+    public:
+        // Visits live entries only; items cancelled earlier are skipped.
+        class iterator {
+            using Base = typename std::deque<Entry>::iterator;
+            Base it_;
+            Base end_;
+
+            void skip_dead() {
+                while (it_ != end_ && !it_->live) {
+                    ++it_;
+                }
+            }
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+            iterator(Base it, Base end) : it_(it), end_(end) {
+                skip_dead();
+            }
+
+            T& operator*() const { return it_->item; }
+            T* operator->() const { return &it_->item; }
+            iterator& operator++() {
+                ++it_;
+                skip_dead();
+                return *this;
+            }
+            iterator operator++(int) {
+                iterator old = *this;
+                ++*this;
+                return old;
+            }
+            bool operator==(const iterator& other) const { return it_ == other.it_; }
+            bool operator!=(const iterator& other) const { return it_ != other.it_; }
+        };
+
+        PendingItems() = default;
+
+        iterator begin() { return iterator(entries_.begin(), entries_.end()); }
+        iterator end() { return iterator(entries_.end(), entries_.end()); }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+    };
+
+    explicit AsyncQueue(size_t capacity = std::numeric_limits<size_t>::max(),
+                        Fairness fairness = Fairness::barging)
+        : capacity_(capacity), fairness_(fairness) {}
 
     virtual ~AsyncQueue() {
         close();
@@ -36,10 +1115,15 @@ public:
 
     // Move operations
     AsyncQueue(AsyncQueue&& other) noexcept
-        : capacity_(other.capacity_) {
+        : capacity_(other.capacity_), fairness_(other.fairness_) {
         std::lock_guard<std::mutex> lock(other.mutex_);
         queue_ = std::move(other.queue_);
+        size_ = std::exchange(other.size_, 0);
+        dead_ = std::exchange(other.dead_, 0);
+        next_seq_ = other.next_seq_;
         closed_ = other.closed_;
+        publish_depth();
+        other.publish_depth();
     }
 
     AsyncQueue& operator=(AsyncQueue&& other) noexcept {
@@ -49,7 +1133,12 @@ public:
             }
             std::scoped_lock lock(mutex_, other.mutex_);
             queue_ = std::move(other.queue_);
+            size_ = std::exchange(other.size_, 0);
+            dead_ = std::exchange(other.dead_, 0);
+            next_seq_ = other.next_seq_;
             closed_ = other.closed_;
+            publish_depth();
+            other.publish_depth();
         }
         return *this;
     }
@@ -59,97 +1148,370 @@ public:
     AsyncQueue& operator=(const AsyncQueue&) = delete;
 
     // Core operations
+
+    // When the queue is full, producers with a higher admission priority
+    // get freed capacity first.
     template<typename U>
-    bool push(U&& item) {
+    bool push(U&& item, int priority = 0) {
         std::unique_lock<std::mutex> lock(mutex_);
-        
-        if (closed_) {
-            return false;
-        }
-
-        cv_.wait(lock, [this] { 
-            return queue_.size() < capacity_ || closed_; 
-        });
 
-        if (closed_) {
+        if (!wait_for_room(lock, priority)) {
             return false;
         }
 
-        queue_.push(std::forward<U>(item));
-        on_push(queue_.back());
-        cv_.notify_one();
+        deliver(std::forward<U>(item));
         return true;
     }
 
     template<typename Rep, typename Period>
     bool try_push(const T& item, 
-                 const std::chrono::duration<Rep, Period>& timeout) {
+                 const std::chrono::duration<Rep, Period>& timeout,
+                 int priority = 0) {
         std::unique_lock<std::mutex> lock(mutex_);
-        
-        if (closed_) {
+
+        if (!wait_for_room(lock, priority, timeout)) {
             return false;
         }
 
-        if (!cv_.wait_for(lock, timeout, [this] { 
-            return queue_.size() < capacity_ || closed_; 
-        })) {
-            return false;
+        deliver(item);
+        return true;
+    }
+
+    // Like push/try_push, but return a handle that cancel() accepts, or
+    // nullopt if the item was not queued.
+    template<typename U>
+    std::optional<ItemHandle> push_tracked(U&& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!wait_for_room(lock, 0)) {
+            return std::nullopt;
         }
 
-        if (closed_) {
+        return ItemHandle{deliver(std::forward<U>(item))};
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<ItemHandle> try_push_tracked(const T& item,
+            const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!wait_for_room(lock, 0, timeout)) {
+            return std::nullopt;
+        }
+
+        return ItemHandle{deliver(item)};
+    }
+
+    // Remove a still-pending item. Returns false if it was already popped
+    // or cancelled. The item's storage is tombstoned in O(1); consumers
+    // skip it and the slot is reclaimed with the next compaction.
+    bool cancel(ItemHandle handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        Entry* entry = find_seq(handle.seq);
+        if (!entry) {
             return false;
         }
 
-        queue_.push(item);
-        on_push(queue_.back());
-        cv_.notify_one();
+        discard(*entry);
+        maybe_compact();
+        notify_waiters();
         return true;
     }
 
-    std::optional<T> pop() {
-        std::unique_lock<std::mutex> lock(mutex_);
-        
-        cv_.wait(lock, [this] { 
-            return !queue_.empty() || closed_; 
-        });
+    // Remove every pending item matching pred. Returns the number removed.
+    template<typename Pred>
+    size_t remove_if(Pred pred) {
+        std::lock_guard<std::mutex> lock(mutex_);
 
-        if (queue_.empty()) {
-            return std::nullopt;
+        size_t removed = 0;
+        for (auto& entry : queue_) {
+            if (entry.live && pred(static_cast<const T&>(entry.item))) {
+                discard(entry);
+                ++removed;
+            }
         }
 
-        T item = std::move(queue_.front());
-        queue_.pop();
-        on_pop(item);
-        cv_.notify_one();
+        if (removed > 0) {
+            maybe_compact();
+            grant_slots();
+            if (fairness_ == Fairness::barging || room_watchers_ > 0) {
+                cv_.notify_all();
+            }
+        }
+        return removed;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto item = pop_wait(lock);
+        run_drop_handler(lock);
         return item;
     }
 
     template<typename Rep, typename Period>
     std::optional<T> try_pop(const std::chrono::duration<Rep, Period>& timeout) {
         std::unique_lock<std::mutex> lock(mutex_);
-        
-        if (!cv_.wait_for(lock, timeout, [this] { 
-            return !queue_.empty() || closed_; 
-        })) {
+        auto item = pop_wait(lock, timeout);
+        run_drop_handler(lock);
+        return item;
+    }
+
+    // Status variants: the outcome comes back as a QueueStatus, so a miss
+    // does not need a second is_closed() call to interpret it. Popped items
+    // are written to out. Pushes only move from item on QueueStatus::ok, so
+    // a rejected move-only item stays with the caller.
+
+    // ok, or closed once the queue is closed and drained.
+    QueueStatus pop_status(T& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto item = pop_wait(lock);
+        run_drop_handler(lock);
+        return finish_pop(std::move(item), out, QueueStatus::closed);
+    }
+
+    // ok, timeout, or closed.
+    template<typename Rep, typename Period>
+    QueueStatus try_pop_status(T& out, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto item = pop_wait(lock, timeout);
+        QueueStatus miss = closed_ ? QueueStatus::closed : QueueStatus::timeout;
+        run_drop_handler(lock);
+        return finish_pop(std::move(item), out, miss);
+    }
+
+    // Never blocks: ok, empty, or closed.
+    QueueStatus try_pop_status(T& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (size_ == 0) {
+            return closed_ ? QueueStatus::closed : QueueStatus::empty;
+        }
+        out = pop_stored();
+        run_drop_handler(lock);
+        return QueueStatus::ok;
+    }
+
+    // ok, or closed.
+    template<typename U>
+    QueueStatus push_status(U&& item, int priority = 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!wait_for_room(lock, priority)) {
+            return QueueStatus::closed;
+        }
+
+        deliver(std::forward<U>(item));
+        return QueueStatus::ok;
+    }
+
+    // ok, timeout, or closed.
+    template<typename U, typename Rep, typename Period>
+    QueueStatus try_push_status(U&& item, const std::chrono::duration<Rep, Period>& timeout,
+                                int priority = 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!wait_for_room(lock, priority, timeout)) {
+            return closed_ ? QueueStatus::closed : QueueStatus::timeout;
+        }
+
+        deliver(std::forward<U>(item));
+        return QueueStatus::ok;
+    }
+
+    // Never blocks: ok, full, or closed.
+    template<typename U>
+    QueueStatus try_push_status(U&& item, int priority = 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (closed_) {
+            return QueueStatus::closed;
+        }
+        if (!may_enter(priority)) {
+            return QueueStatus::full;
+        }
+
+        deliver(std::forward<U>(item));
+        return QueueStatus::ok;
+    }
+
+    // Move up to max pending items to out under a single lock acquisition,
+    // waiting until at least one is available. Returns how many were
+    // popped; 0 once the queue is closed and drained.
+    template<typename OutputIt>
+    size_t pop_bulk(OutputIt out, size_t max) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto emit = [&out](Entry&& entry) {
+            *out = std::move(entry.item);
+            ++out;
+        };
+        size_t count = pop_bulk_wait(lock, max, emit);
+        run_drop_handler(lock);
+        return count;
+    }
+
+    // Like pop_bulk, but returns 0 if nothing arrives within timeout.
+    template<typename OutputIt, typename Rep, typename Period>
+    size_t try_pop_bulk(OutputIt out, size_t max,
+                        const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto emit = [&out](Entry&& entry) {
+            *out = std::move(entry.item);
+            ++out;
+        };
+        size_t count = pop_bulk_wait(lock, max, emit, timeout);
+        run_drop_handler(lock);
+        return count;
+    }
+
+    // Range over popped items for `for (auto& item : queue.consume())`,
+    // fetching up to batch items per lock acquisition.
+    ConsumeRange consume(size_t batch = 64) {
+        return ConsumeRange(*this, batch);
+    }
+
+    // Selective receive: remove the first pending item matching pred,
+    // waiting until one arrives. Returns nullopt once the queue is closed
+    // and nothing pending matches. Non-matching items keep their order.
+    template<typename Pred>
+    std::optional<T> pop_if(Pred pred) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        Entry* match = wait_match(lock, pred);
+        if (!match) {
             return std::nullopt;
         }
 
-        if (queue_.empty()) {
+        T item = take(*match);
+        on_pop(item);
+        notify_waiters();
+        return item;
+    }
+
+    template<typename Pred, typename Rep, typename Period>
+    std::optional<T> try_pop_if(Pred pred,
+                                const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        Entry* match = wait_match_for(lock, pred, timeout);
+        if (!match) {
             return std::nullopt;
         }
 
-        T item = std::move(queue_.front());
-        queue_.pop();
+        T item = take(*match);
         on_pop(item);
-        cv_.notify_one();
+        notify_waiters();
         return item;
     }
 
     void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        close_locked();
+    }
+
+    // Close the queue, then wait until consumers have taken every pending
+    // item or the deadline passes. Items in a consume() batch count as
+    // pending until the range moves past its batch, since it could still
+    // give them back. Returns true if the queue drained. On timeout the
+    // leftovers stay queued; abort() can collect them.
+    template<typename Clock, typename Duration>
+    bool close_and_drain(const std::chrono::time_point<Clock, Duration>& deadline) {
         std::unique_lock<std::mutex> lock(mutex_);
-        closed_ = true;
-        on_close();
-        cv_.notify_all();
+        close_locked();
+
+        ++drain_waiters_;
+        bool drained = drained_cv_.wait_until(lock, deadline, [this] {
+            return size_ == 0 && held_ == 0;
+        });
+        --drain_waiters_;
+        return drained;
+    }
+
+    // Close the queue and take every pending item out of it at once, e.g.
+    // to persist unfinished work. Consumers see an empty, closed queue.
+    // Items already in a consume() batch are not included; if the range
+    // gives them back, they are cancelled (on_cancel) rather than stored.
+    PendingItems abort() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        close_locked();
+        discard_held_ = true;
+
+        PendingItems pending(std::move(queue_), size_);
+        queue_ = std::deque<Entry>();
+        size_ = 0;
+        dead_ = 0;
+        publish_depth();
+        on_clear();
+        if (drain_waiters_ > 0) {
+            drained_cv_.notify_all();
+        }
+        return pending;
+    }
+
+    // Close the queue, drop any pending items, and wait until every thread
+    // parked in it has woken and left, and every consume() range has moved
+    // past or dropped its batch, so that it can be reset() or destroyed.
+    // Items a range gives back are cancelled. Threads that are not yet
+    // parked must not touch it again.
+    void wait_until_idle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        close_locked();
+        discard_held_ = true;
+        if (!queue_.empty()) {
+            queue_.clear();
+            on_clear();
+        }
+        size_ = 0;
+        dead_ = 0;
+        publish_depth();
+        if (drain_waiters_ > 0) {
+            drained_cv_.notify_all();
+        }
+        // Woken threads re-take the mutex to unlink themselves; none can
+        // park again in a closed, empty queue.
+        while (has_waiters()) {
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+        }
+    }
+
+    // Make the queue reusable: drop any pending items and reopen it,
+    // keeping the mutex, condition variables and deque map, so a recycled
+    // queue costs no allocation. Sequence numbers keep counting, so handles
+    // from before the reset never match new items. Settings go back to
+    // their defaults: no capacity is reserved, CoDel and adaptive LIFO are
+    // off and no notifier is set, so a drop handler or notifier from before
+    // the reset is never called. stats() and lifo_stats() start from zero.
+    // Only call this once no thread is using the queue; returns false,
+    // changing nothing, if one is still parked in it.
+    bool reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (has_waiters()) {
+            return false;
+        }
+        if (!queue_.empty()) {
+            queue_.clear();
+            on_clear();
+        }
+        size_ = 0;
+        dead_ = 0;
+        closed_ = false;
+        discard_held_ = false;
+        reserved_ = 0;
+        reserved_min_priority_ = 0;
+        codel_.reset();
+        drop_handler_ = nullptr;
+        lifo_threshold_.reset();
+        lifo_ = false;
+        notifier_ = nullptr;
+        dwell_ns_.store(0, std::memory_order_relaxed);
+        dropped_.store(0, std::memory_order_relaxed);
+        mode_since_ = {};
+        fifo_time_ = std::chrono::nanoseconds::zero();
+        lifo_time_ = std::chrono::nanoseconds::zero();
+        mode_switches_ = 0;
+        publish_depth();
+        return true;
     }
 
     // Queue state
@@ -160,18 +1522,110 @@ public:
 
     bool empty() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.empty();
+        return size_ == 0;
     }
 
     size_t size() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.size();
+        return size_;
     }
 
     size_t capacity() const {
         return capacity_;
     }
 
+    // Depth and dwell time without touching mutex_, for monitoring and
+    // autoscaling. The figures may be slightly stale. Items handed
+    // straight to a parked consumer count as zero dwell.
+    QueueStats stats() const {
+        QueueStats stats;
+        stats.depth = depth_.load(std::memory_order_relaxed);
+        stats.dwell = std::chrono::nanoseconds(dwell_ns_.load(std::memory_order_relaxed));
+        stats.dropped = dropped_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // Bound queueing delay rather than just count: with CoDel enabled,
+    // pop() and try_pop() (and their status variants) drop stale items at
+    // the front once the delay has stayed above policy.target for
+    // policy.interval. Selective pops are never affected. on_drop, if set,
+    // receives each dropped item on the popping thread once mutex_ is
+    // released, so it may block, e.g. to divert the item into another queue.
+    void set_codel(CoDelPolicy policy, std::function<void(T)> on_drop = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        codel_.emplace(policy);
+        drop_handler_ = std::move(on_drop);
+    }
+
+    void disable_codel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        codel_.reset();
+        drop_handler_ = nullptr;
+    }
+
+    // Serve FIFO normally, but switch pop()/try_pop() to newest-first while
+    // the oldest pending item has waited longer than threshold, so fresh
+    // requests still meet their deadlines during overload. Old items keep
+    // waiting (or age out through cancel() or CoDel); FIFO order resumes
+    // once the backlog is down to a single item.
+    void set_adaptive_lifo(std::chrono::nanoseconds threshold) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!lifo_threshold_) {
+            mode_since_ = std::chrono::steady_clock::now();
+        }
+        lifo_threshold_ = threshold;
+    }
+
+    void disable_adaptive_lifo() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (lifo_threshold_) {
+            account_mode(std::chrono::steady_clock::now());
+            lifo_ = false;
+            lifo_threshold_.reset();
+        }
+    }
+
+    LifoStats lifo_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        LifoStats stats;
+        stats.lifo = lifo_;
+        stats.fifo_time = fifo_time_;
+        stats.lifo_time = lifo_time_;
+        stats.switches = mode_switches_;
+        if (lifo_threshold_) {
+            auto current = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - mode_since_);
+            (lifo_ ? stats.lifo_time : stats.fifo_time) += current;
+        }
+        return stats;
+    }
+
+    // Report stored items and close to notifier, or stop with nullptr. If
+    // items are already pending or the queue is closed, it is told at once.
+    // The notifier must outlive the queue, or be unset (reset() also unsets
+    // it) first.
+    void set_notifier(ReadinessNotifier* notifier) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        notifier_ = notifier;
+        if (notifier_ && (size_ > 0 || closed_)) {
+            notifier_->notify();
+        }
+    }
+
+    Fairness fairness() const {
+        return fairness_;
+    }
+
+    // Set aside the last `slots` of capacity for pushes with an admission
+    // priority of at least min_priority, so they never wait behind a queue
+    // flooded by lower priorities.
+    void reserve_capacity(size_t slots, int min_priority) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reserved_ = slots;
+        reserved_min_priority_ = min_priority;
+        notify_waiters();
+    }
+
     // Helper for extensions
     template<typename E>
     bool has_extension() const {
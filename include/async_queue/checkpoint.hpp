@@ -0,0 +1,147 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace async_queue {
+
+// Checkpoint format, native byte order:
+//
+//   CheckpointHeader
+//   count records, each: uint64_t length, length payload bytes, zero
+//   padding up to the next multiple of 8
+//
+// Every record starts 8-byte aligned relative to the header, so a
+// checkpoint file can be mmap()ed and handed to restore() as is.
+struct CheckpointHeader {
+    char magic[8];
+    uint64_t count;          // number of records
+    uint64_t payload_bytes;  // bytes following the header
+};
+
+inline constexpr char checkpoint_magic[8] = {'A', 'Q', 'C', 'K', 'P', 'T', '0', '1'};
+
+namespace detail {
+
+inline size_t checkpoint_padding(size_t length) {
+    return (8 - length % 8) % 8;
+}
+
+// Implements snapshot() and restore() with access to AsyncQueue internals.
+struct Checkpoint {
+    template<typename T>
+    static std::vector<T> copy_pending(AsyncQueue<T>& queue) {
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        std::vector<T> items;
+        items.reserve(queue.size_);
+        for (const auto& entry : queue.queue_) {
+            if (entry.live) {
+                items.push_back(entry.item);
+            }
+        }
+        return items;
+    }
+
+    template<typename T>
+    static bool load(AsyncQueue<T>& queue, std::vector<T>& items) {
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        if (queue.closed_) {
+            return false;
+        }
+        for (auto& item : items) {
+            queue.deliver(std::move(item));
+        }
+        return true;
+    }
+};
+
+} // namespace detail
+
+// Write the queue's pending items, oldest first, as one checkpoint image.
+//
+// serializer(item, out) appends an item's bytes to a std::vector<char>;
+// sink(data, size) receives the finished image in a single call. The
+// queue is locked only while its pending items are copied out, so
+// serialization and I/O never block producers or consumers, and the
+// checkpoint is a consistent cut of the queue. Returns the item count.
+template<typename T, typename Serializer, typename Sink>
+size_t snapshot(AsyncQueue<T>& queue, Serializer&& serializer, Sink&& sink) {
+    std::vector<T> items = detail::Checkpoint::copy_pending(queue);
+
+    std::vector<char> image(sizeof(CheckpointHeader));
+    for (const auto& item : items) {
+        // Reserve the length word, serialize in place, then backfill it.
+        size_t at = image.size();
+        image.resize(at + sizeof(uint64_t));
+        serializer(static_cast<const T&>(item), image);
+        uint64_t length = image.size() - at - sizeof(uint64_t);
+        std::memcpy(image.data() + at, &length, sizeof(length));
+        image.resize(image.size() + detail::checkpoint_padding(length));
+    }
+
+    CheckpointHeader header;
+    std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+    header.count = items.size();
+    header.payload_bytes = image.size() - sizeof(CheckpointHeader);
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    sink(static_cast<const char*>(image.data()), image.size());
+    return items.size();
+}
+
+// Load a checkpoint image into the queue, after anything already pending.
+//
+// deserializer(data, size) rebuilds one item from its bytes, which point
+// into the image; nothing is copied per record. Items are decoded before
+// the queue is locked and then added in one locked pass. Capacity is not
+// enforced, so a restored queue may start over capacity; producers wait
+// until consumers catch up. Returns the number of items restored, or
+// nullopt, restoring nothing, if the image is malformed or the queue is
+// closed.
+template<typename T, typename Deserializer>
+std::optional<size_t> restore(AsyncQueue<T>& queue, const char* data, size_t size,
+                              Deserializer&& deserializer) {
+    CheckpointHeader header;
+    if (size < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) != 0 ||
+        header.payload_bytes != size - sizeof(header) ||
+        header.count > header.payload_bytes / sizeof(uint64_t)) {
+        return std::nullopt;
+    }
+
+    std::vector<T> items;
+    items.reserve(static_cast<size_t>(header.count));
+    const char* pos = data + sizeof(header);
+    const char* end = data + size;
+    for (uint64_t i = 0; i < header.count; ++i) {
+        uint64_t length;
+        if (static_cast<size_t>(end - pos) < sizeof(length)) {
+            return std::nullopt;
+        }
+        std::memcpy(&length, pos, sizeof(length));
+        pos += sizeof(length);
+        size_t left = static_cast<size_t>(end - pos);
+        if (length > left || detail::checkpoint_padding(length) > left - length) {
+            return std::nullopt;
+        }
+        items.push_back(deserializer(pos, static_cast<size_t>(length)));
+        pos += length + detail::checkpoint_padding(length);
+    }
+    if (pos != end) {
+        return std::nullopt;
+    }
+
+    if (!detail::Checkpoint::load(queue, items)) {
+        return std::nullopt;
+    }
+    return items.size();
+}
+
+} // namespace async_queue
@@ -0,0 +1,91 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace async_queue {
+
+// CoDel active queue management settings (see RFC 8289). Items are dropped
+// at dequeue once the shortest time any item spent queued has stayed above
+// target for a whole interval; drops then speed up with the square root of
+// the drop count until the queueing delay falls back under target.
+struct CoDelPolicy {
+    std::chrono::nanoseconds target = std::chrono::milliseconds(5);
+    std::chrono::nanoseconds interval = std::chrono::milliseconds(100);
+};
+
+namespace detail {
+
+// The CoDel control loop, asked once per front item at dequeue.
+class CoDel {
+    using Clock = std::chrono::steady_clock;
+
+    CoDelPolicy policy_;
+    bool dropping_ = false;
+    Clock::time_point first_above_{};  // when sojourn may start counting as bad
+    Clock::time_point drop_next_{};
+    uint32_t count_ = 0;
+    uint32_t last_count_ = 0;
+
+    Clock::time_point control_law(Clock::time_point t, uint32_t count) const {
+        auto step = std::chrono::duration<double, std::nano>(policy_.interval) /
+                    std::sqrt(static_cast<double>(count));
+        return t + std::chrono::duration_cast<Clock::duration>(step);
+    }
+
+    // Whether the delay has stayed above target for a full interval.
+    bool above_target(Clock::time_point enqueued, Clock::time_point now, size_t queued) {
+        // Never drop the last item: a single item is not a standing queue.
+        if (now - enqueued < policy_.target || queued <= 1) {
+            first_above_ = Clock::time_point{};
+            return false;
+        }
+        if (first_above_ == Clock::time_point{}) {
+            first_above_ = now + policy_.interval;
+            return false;
+        }
+        return now >= first_above_;
+    }
+
+public:
+    explicit CoDel(CoDelPolicy policy = CoDelPolicy()) : policy_(policy) {}
+
+    // Whether the front item, enqueued at enqueued with queued items
+    // pending, should be dropped. After a drop the caller asks again about
+    // the new front item.
+    bool should_drop(Clock::time_point enqueued, Clock::time_point now, size_t queued) {
+        bool above = above_target(enqueued, now, queued);
+        if (dropping_) {
+            if (!above) {
+                dropping_ = false;
+                return false;
+            }
+            if (now < drop_next_) {
+                return false;
+            }
+            ++count_;
+            drop_next_ = control_law(drop_next_, count_);
+            return true;
+        }
+        if (!above) {
+            return false;
+        }
+        // Enter the dropping state. If it was left only recently, resume
+        // near the previous drop rate instead of starting over.
+        dropping_ = true;
+        uint32_t delta = count_ - last_count_;
+        count_ = delta > 1 && now - drop_next_ < 16 * policy_.interval ? delta : 1;
+        drop_next_ = control_law(now, count_);
+        last_count_ = count_;
+        return true;
+    }
+
+    bool dropping() const {
+        return dropping_;
+    }
+};
+
+} // namespace detail
+
+} // namespace async_queue
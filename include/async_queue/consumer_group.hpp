@@ -0,0 +1,191 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace async_queue {
+
+// When a ConsumerGroup adds and retires workers.
+struct ScalingPolicy {
+    size_t min_threads = 1;
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    // Add a worker when more than this many items are pending per worker...
+    size_t depth_per_thread = 16;
+    // ...or when items wait longer than this on average.
+    std::chrono::nanoseconds max_dwell = std::chrono::milliseconds(10);
+    // A worker above min_threads that finds no work for this long retires.
+    std::chrono::milliseconds idle_timeout = std::chrono::seconds(1);
+    // How often the supervisor samples the queue's stats.
+    std::chrono::milliseconds check_interval = std::chrono::milliseconds(10);
+};
+
+// Runs handler on every item of an AsyncQueue with a pool of worker
+// threads that grows and shrinks with the backlog.
+//
+// A supervisor thread samples the queue's lock-free stats() every
+// check_interval and adds one worker per sample while the depth per worker
+// or the dwell time is over the policy's limits. Workers that stay idle for
+// idle_timeout retire, down to min_threads. Workers exit once the queue is
+// closed and drained, or when stop() is called; stop() leaves any pending
+// items in the queue. The queue must outlive the group.
+template<typename T>
+class ConsumerGroup {
+public:
+    using Handler = std::function<void(T)>;
+
+protected:
+    struct Worker {
+        std::thread thread;
+        bool done = false;
+    };
+
+    AsyncQueue<T>& queue_;
+    Handler handler_;
+    const ScalingPolicy policy_;
+
+    std::mutex mutex_;
+    std::condition_variable stop_cv_;
+    std::list<Worker> workers_;
+    size_t active_ = 0;
+    bool stopping_ = false;
+    std::thread supervisor_;
+
+    // mutex_ must be held.
+    void spawn() {
+        workers_.emplace_back();
+        Worker* worker = &workers_.back();
+        ++active_;
+        worker->thread = std::thread([this, worker] {
+            run(*worker);
+        });
+    }
+
+    // mutex_ must be held.
+    void retire(Worker& worker) {
+        --active_;
+        worker.done = true;
+    }
+
+    void run(Worker& worker) {
+        // Poll in short slices so stop() is noticed promptly.
+        auto slice = std::min<std::chrono::milliseconds>(policy_.idle_timeout,
+                                                         std::chrono::milliseconds(50));
+        auto idle_since = std::chrono::steady_clock::now();
+        for (;;) {
+            bool closed = false;
+            bool idle = false;
+            if (auto item = queue_.try_pop(slice)) {
+                handler_(std::move(*item));
+                idle_since = std::chrono::steady_clock::now();
+            } else {
+                closed = queue_.is_closed();
+                idle = std::chrono::steady_clock::now() - idle_since >= policy_.idle_timeout;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_ || closed) {
+                retire(worker);
+                return;
+            }
+            if (idle) {
+                if (active_ > policy_.min_threads) {
+                    retire(worker);
+                    return;
+                }
+                idle_since = std::chrono::steady_clock::now();
+            }
+        }
+    }
+
+    // Join workers that have exited; mutex_ must be held.
+    void reap() {
+        for (auto it = workers_.begin(); it != workers_.end();) {
+            if (it->done) {
+                it->thread.join();
+                it = workers_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void supervise() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            reap();
+            QueueStats stats = queue_.stats();
+            if (stats.depth == 0 && queue_.is_closed()) {
+                break;  // Workers drain and exit on their own
+            }
+            bool backlog = stats.depth > active_ * policy_.depth_per_thread ||
+                           (stats.depth > 0 && stats.dwell > policy_.max_dwell);
+            if (active_ < policy_.min_threads ||
+                (backlog && active_ < policy_.max_threads)) {
+                spawn();
+            }
+            stop_cv_.wait_for(lock, policy_.check_interval, [this] {
+                return stopping_;
+            });
+        }
+    }
+
+public:
+    ConsumerGroup(AsyncQueue<T>& queue, Handler handler, ScalingPolicy policy = ScalingPolicy())
+        : queue_(queue), handler_(std::move(handler)), policy_([&] {
+              policy.max_threads = std::max<size_t>({policy.max_threads, policy.min_threads, 1});
+              return policy;
+          }()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < policy_.min_threads; ++i) {
+            spawn();
+        }
+        supervisor_ = std::thread([this] {
+            supervise();
+        });
+    }
+
+    ~ConsumerGroup() {
+        stop();
+    }
+
+    ConsumerGroup(const ConsumerGroup&) = delete;
+    ConsumerGroup& operator=(const ConsumerGroup&) = delete;
+
+    // Stop and join every thread. Items being handled finish; pending items
+    // stay in the queue.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+            stop_cv_.notify_all();
+        }
+        supervisor_.join();
+
+        // Exiting workers still take mutex_, so join them without it. List
+        // nodes keep their addresses when spliced.
+        std::list<Worker> workers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            workers.splice(workers.end(), workers_);
+        }
+        for (auto& worker : workers) {
+            worker.thread.join();
+        }
+    }
+
+    // Workers currently running.
+    size_t threads() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return active_;
+    }
+};
+
+} // namespace async_queue
@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
+namespace async_queue {
+
+// Futex waits on a 32-bit atomic word, shared by the queues that park
+// without a mutex (Oneshot, SpscQueue).
+namespace detail {
+
+// Block while *word == expected, for at most timeout if one is given.
+// May return early or spuriously; callers re-check their condition.
+inline void futex_wait(std::atomic<uint32_t>* word, uint32_t expected,
+                       const std::chrono::nanoseconds* timeout = nullptr) {
+#if defined(__linux__)
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                  "futex word must be a plain 32-bit integer");
+    struct timespec ts;
+    struct timespec* tsp = nullptr;
+    if (timeout) {
+        auto ns = timeout->count() > 0 ? timeout->count() : 0;
+        ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000);
+        tsp = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE,
+            expected, tsp, nullptr, 0);
+#else
+    // No futex: back off politely and let the caller re-check.
+    (void)expected;
+    auto pause = std::chrono::microseconds(50);
+    if (timeout && *timeout < pause) {
+        pause = std::chrono::duration_cast<std::chrono::microseconds>(*timeout);
+    }
+    if (word->load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(pause);
+    }
+#endif
+}
+
+inline void futex_wake_all(std::atomic<uint32_t>* word) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE,
+            INT32_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+} // namespace detail
+
+} // namespace async_queue
@@ -0,0 +1,131 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+
+namespace async_queue {
+
+// AsyncQueue with a secondary index on a key extracted from each item, so
+// selective receive by key (correlation ID, message type, ...) does not scan
+// the pending items under mutex_.
+//
+// The index maps each key to the sequence numbers of its pending items in
+// push order. Entries for items removed through other paths (pop, pop_if)
+// go stale and are pruned lazily.
+template<typename T, typename KeyFn>
+class IndexedAsyncQueue : public AsyncQueue<T> {
+public:
+    using Key = std::decay_t<std::invoke_result_t<KeyFn&, const T&>>;
+
+protected:
+    using Base = AsyncQueue<T>;
+    using Entry = typename Base::Entry;
+
+    KeyFn key_fn_;
+    std::unordered_map<Key, std::deque<uint64_t>> index_;
+
+    void on_push(const T& item) override {
+        // Items handed straight to a parked consumer are never stored.
+        if (!this->queue_.empty() && &this->queue_.back().item == &item) {
+            index_[key_fn_(item)].push_back(this->queue_.back().seq);
+        }
+    }
+
+    // The item returns to its old place, so its seq goes back in order.
+    void on_requeue(const T& item, uint64_t seq) override {
+        auto& seqs = index_[key_fn_(item)];
+        auto pos = std::lower_bound(seqs.begin(), seqs.end(), seq);
+        if (pos == seqs.end() || *pos != seq) {
+            seqs.insert(pos, seq);
+        }
+    }
+
+    void on_pop(const T& item) override {
+        auto it = index_.find(key_fn_(item));
+        if (it != index_.end()) {
+            prune(it);
+        }
+    }
+
+    void on_cancel(const T& item) override {
+        on_pop(item);
+    }
+
+    void on_clear() override {
+        index_.clear();
+    }
+
+    // Drop stale sequence numbers from the front of a key's list.
+    // Returns the first live entry for the key, or nullptr.
+    Entry* prune(typename std::unordered_map<Key, std::deque<uint64_t>>::iterator it) {
+        auto& seqs = it->second;
+        while (!seqs.empty()) {
+            if (Entry* entry = this->find_seq(seqs.front())) {
+                return entry;
+            }
+            seqs.pop_front();
+        }
+        index_.erase(it);
+        return nullptr;
+    }
+
+    Entry* find_key(const Key& key) {
+        auto it = index_.find(key);
+        return it == index_.end() ? nullptr : prune(it);
+    }
+
+public:
+    explicit IndexedAsyncQueue(KeyFn key_fn = KeyFn(),
+                               size_t capacity = std::numeric_limits<size_t>::max())
+        : Base(capacity), key_fn_(std::move(key_fn)) {}
+
+    // Remove the oldest pending item whose key equals key, waiting until one
+    // arrives. Returns nullopt once the queue is closed and none is pending.
+    std::optional<T> pop_key(const Key& key) {
+        std::unique_lock<std::mutex> lock(this->mutex_);
+
+        Entry* match = nullptr;
+        ++this->selective_waiters_;
+        this->cv_.wait(lock, [&] {
+            match = find_key(key);
+            return match != nullptr || this->closed_;
+        });
+        --this->selective_waiters_;
+
+        if (!match) {
+            return std::nullopt;
+        }
+
+        T item = this->take(*match);
+        on_pop(item);
+        this->notify_waiters();
+        return item;
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<T> try_pop_key(const Key& key,
+                                 const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(this->mutex_);
+
+        Entry* match = nullptr;
+        ++this->selective_waiters_;
+        this->cv_.wait_for(lock, timeout, [&] {
+            match = find_key(key);
+            return match != nullptr || this->closed_;
+        });
+        --this->selective_waiters_;
+
+        if (!match) {
+            return std::nullopt;
+        }
+
+        T item = this->take(*match);
+        on_pop(item);
+        this->notify_waiters();
+        return item;
+    }
+};
+
+} // namespace async_queue
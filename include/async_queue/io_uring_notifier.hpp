@@ -0,0 +1,158 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(__linux__)
+#error "io_uring_notifier.hpp requires Linux"
+#endif
+
+#include <linux/futex.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace async_queue {
+
+// Wakes an io_uring event loop when queues it drains get items, without a
+// thread blocked in pop() and without a syscall per item.
+//
+// The loop owns the ring and submits the wait this notifier prepares:
+//
+//   for (;;) {
+//       drain the queues with try_pop(0ms);
+//       if (notifier.arm(*sqe, tag)) {
+//           submit sqe, then handle completions; on tag's CQE:
+//           notifier.consume();
+//       }   // else: something arrived meanwhile; drain again
+//   }
+//
+// On kernels with IORING_OP_FUTEX_WAIT (6.7+) the wait is on a futex word
+// inside the notifier, and producers wake it with one FUTEX_WAKE. Older
+// kernels fall back to a read of an eventfd, and producers write to it.
+// Either way notify() only makes a syscall when the loop has armed a wait:
+// a burst of pushes while the loop is awake, or after it was woken, costs
+// one atomic load per push. At most one wait may be armed at a time.
+class IoUringNotifier : public ReadinessNotifier {
+public:
+    enum class Mode {
+        futex,
+        eventfd,
+    };
+
+    // Use futex waits if ring_fd's io_uring supports them, else an eventfd.
+    explicit IoUringNotifier(int ring_fd) : IoUringNotifier(probe(ring_fd)) {}
+
+    explicit IoUringNotifier(Mode mode) : mode_(mode) {
+        if (mode_ == Mode::eventfd) {
+            eventfd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        }
+    }
+
+    ~IoUringNotifier() {
+        if (eventfd_ >= 0) {
+            ::close(eventfd_);
+        }
+    }
+
+    IoUringNotifier(const IoUringNotifier&) = delete;
+    IoUringNotifier& operator=(const IoUringNotifier&) = delete;
+
+    Mode mode() const {
+        return mode_;
+    }
+
+    // The eventfd waited on in eventfd mode, -1 in futex mode.
+    int eventfd() const {
+        return eventfd_;
+    }
+
+    // Whether ring_fd's io_uring supports IORING_OP_FUTEX_WAIT.
+    static bool supports_futex_wait(int ring_fd) {
+        constexpr unsigned ops = 256;
+        alignas(io_uring_probe) unsigned char buffer[sizeof(io_uring_probe) +
+                                                     ops * sizeof(io_uring_probe_op)];
+        std::memset(buffer, 0, sizeof(buffer));
+        auto* probe = reinterpret_cast<io_uring_probe*>(buffer);
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, ops) < 0) {
+            return false;
+        }
+        return probe->last_op >= op_futex_wait &&
+               (probe->ops[op_futex_wait].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    // Loop side, after draining. Returns false if items arrived since the
+    // last consume(): drain again rather than wait. Otherwise fills sqe
+    // with the wait to submit, tagged with user_data.
+    bool arm(io_uring_sqe& sqe, uint64_t user_data) {
+        uint32_t expected = quiet;
+        if (!state_.compare_exchange_strong(expected, armed, std::memory_order_acq_rel)) {
+            state_.store(quiet, std::memory_order_release);
+            return false;
+        }
+        std::memset(&sqe, 0, sizeof(sqe));
+        if (mode_ == Mode::futex) {
+            sqe.opcode = op_futex_wait;
+            sqe.fd = futex2_size_u32 | futex2_private;
+            sqe.addr = reinterpret_cast<uint64_t>(&state_);
+            sqe.addr2 = armed;  // Completes at once if notify() got there first
+            sqe.addr3 = FUTEX_BITSET_MATCH_ANY;
+        } else {
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = eventfd_;
+            sqe.addr = reinterpret_cast<uint64_t>(&counter_);
+            sqe.len = sizeof(counter_);
+        }
+        sqe.user_data = user_data;
+        return true;
+    }
+
+    // Loop side: the armed wait completed, with any result. Call before
+    // draining.
+    void consume() {
+        state_.store(quiet, std::memory_order_release);
+    }
+
+    // Producer side, called by the queues. Coalesces: only the first
+    // notify after arm() makes a syscall.
+    void notify() override {
+        if (state_.load(std::memory_order_acquire) == signalled) {
+            return;
+        }
+        if (state_.exchange(signalled, std::memory_order_acq_rel) != armed) {
+            return;
+        }
+        if (mode_ == Mode::futex) {
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_), FUTEX_WAKE_PRIVATE, 1,
+                    nullptr, nullptr, 0);
+        } else {
+            uint64_t one = 1;
+            ssize_t written = ::write(eventfd_, &one, sizeof(one));
+            (void)written;  // Only fails if the counter is full, i.e. already readable
+        }
+    }
+
+private:
+    // Not in older uapi headers: IORING_OP_FUTEX_WAIT and the futex2
+    // flags, all from Linux 6.7.
+    static constexpr uint8_t op_futex_wait = 51;
+    static constexpr uint32_t futex2_size_u32 = 0x02;
+    static constexpr uint32_t futex2_private = 128;
+
+    static constexpr uint32_t quiet = 0;      // loop awake, will drain
+    static constexpr uint32_t armed = 1;      // loop waiting on the ring
+    static constexpr uint32_t signalled = 2;  // items arrived since consume()
+
+    static Mode probe(int ring_fd) {
+        return supports_futex_wait(ring_fd) ? Mode::futex : Mode::eventfd;
+    }
+
+    const Mode mode_;
+    int eventfd_ = -1;
+    std::atomic<uint32_t> state_{quiet};
+    uint64_t counter_ = 0;  // eventfd read target
+};
+
+} // namespace async_queue
@@ -0,0 +1,246 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+
+namespace async_queue {
+
+namespace detail {
+
+// Seqlock slot for trivially copyable values. The value is stored as
+// relaxed atomic words so racing reads are well defined; a reader retries
+// if the sequence number was odd or changed while it copied.
+template<typename T>
+class SeqlockSlot {
+    static constexpr size_t words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> seq_{0};  // odd while a write is in progress
+    std::array<std::atomic<uint64_t>, words> data_{};
+
+public:
+    uint64_t store(const T& value) {
+        uint64_t buf[words] = {};
+        std::memcpy(buf, &value, sizeof(T));
+
+        // Writers only exclude each other, never readers.
+        uint64_t seq = seq_.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((seq & 1) == 0 &&
+                seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed)) {
+                break;
+            }
+            if (seq & 1) {
+                std::this_thread::yield();
+                seq = seq_.load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < words; ++i) {
+            data_[i].store(buf[i], std::memory_order_relaxed);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+        return (seq + 2) / 2;
+    }
+
+    // Value if its version is newer than version, which is then updated.
+    std::optional<T> load_newer(uint64_t& version) const {
+        uint64_t buf[words];
+        for (;;) {
+            uint64_t before = seq_.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < words; ++i) {
+                buf[i] = data_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == before) {
+                if (before / 2 <= version) {
+                    return std::nullopt;
+                }
+                version = before / 2;
+                T value;
+                std::memcpy(&value, buf, sizeof(T));
+                return value;
+            }
+        }
+    }
+
+    uint64_t version() const {
+        return seq_.load(std::memory_order_acquire) / 2;
+    }
+};
+
+// Slot for other values: each write publishes an immutable snapshot, so a
+// reader copies from a snapshot no writer will touch again.
+template<typename T>
+class SnapshotSlot {
+    struct Snapshot {
+        T value;
+        uint64_t version;
+    };
+
+    std::shared_ptr<const Snapshot> current_;
+    std::atomic<uint64_t> version_{0};
+    std::mutex write_mutex_;  // orders concurrent writers only
+
+public:
+    uint64_t store(const T& value) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        uint64_t version = version_.load(std::memory_order_relaxed) + 1;
+        std::atomic_store_explicit(&current_,
+            std::shared_ptr<const Snapshot>(std::make_shared<Snapshot>(Snapshot{value, version})),
+            std::memory_order_release);
+        version_.store(version, std::memory_order_release);
+        return version;
+    }
+
+    std::optional<T> load_newer(uint64_t& version) const {
+        auto snapshot = std::atomic_load_explicit(&current_, std::memory_order_acquire);
+        if (!snapshot || snapshot->version <= version) {
+            return std::nullopt;
+        }
+        version = snapshot->version;
+        return snapshot->value;
+    }
+
+    uint64_t version() const {
+        return version_.load(std::memory_order_acquire);
+    }
+};
+
+} // namespace detail
+
+// Single-slot, lossy mailbox for "latest state" streams.
+//
+// publish() always overwrites and never waits for readers; readers see the
+// newest value and never block the writer. Every publish bumps a version
+// number (starting at 1) so readers can tell whether anything changed.
+// Trivially copyable values use a seqlock; other types are published as
+// immutable shared snapshots.
+template<typename T>
+class Mailbox {
+protected:
+    using Slot = std::conditional_t<
+        std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>,
+        detail::SeqlockSlot<T>, detail::SnapshotSlot<T>>;
+
+    Slot slot_;
+    std::atomic<bool> closed_{false};
+
+    // Only readers blocked in wait_for_update use these. The writer takes
+    // mutex_ just long enough to notify, and only if someone is waiting.
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;
+    mutable std::atomic<size_t> waiters_{0};
+
+    void wake_waiters() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+    }
+
+    std::optional<T> read_newer(uint64_t& version) const {
+        return slot_.load_newer(version);
+    }
+
+    void add_waiter() const {
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in wake_waiters: either the writer sees this
+        // waiter or the waiter's next read sees the new version.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+public:
+    Mailbox() = default;
+
+    ~Mailbox() {
+        close();
+    }
+
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    // Replace the current value. Returns its version.
+    uint64_t publish(const T& value) {
+        uint64_t version = slot_.store(value);
+        wake_waiters();
+        return version;
+    }
+
+    // Latest value, or nullopt if nothing was published yet.
+    std::optional<T> load() const {
+        uint64_t version = 0;
+        return read_newer(version);
+    }
+
+    // Latest value and its version.
+    std::optional<T> load(uint64_t& version) const {
+        version = 0;
+        return read_newer(version);
+    }
+
+    uint64_t version() const {
+        return slot_.version();
+    }
+
+    // Wait for a value newer than version, then return it and update
+    // version. Returns nullopt if the mailbox is closed first.
+    std::optional<T> wait_for_update(uint64_t& version) const {
+        if (auto value = read_newer(version)) {
+            return value;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        add_waiter();
+        std::optional<T> value;
+        cv_.wait(lock, [&] {
+            value = read_newer(version);
+            return value.has_value() || closed_.load(std::memory_order_acquire);
+        });
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return value;
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<T> try_wait_for_update(uint64_t& version,
+            const std::chrono::duration<Rep, Period>& timeout) const {
+        if (auto value = read_newer(version)) {
+            return value;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        add_waiter();
+        std::optional<T> value;
+        cv_.wait_for(lock, timeout, [&] {
+            value = read_newer(version);
+            return value.has_value() || closed_.load(std::memory_order_acquire);
+        });
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return value;
+    }
+
+    // Release readers blocked in wait_for_update. The last value stays
+    // readable and publish() keeps working.
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+    }
+
+    bool is_closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+};
+
+} // namespace async_queue
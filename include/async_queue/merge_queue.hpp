@@ -0,0 +1,279 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace async_queue {
+
+// K-way ordered merge of sorted producer streams.
+//
+// Each producer owns a lane and pushes items in non-decreasing order
+// (according to Compare). pop() returns the smallest head across all lanes,
+// producing one globally ordered stream.
+//
+// Watermark semantics: an open, empty lane might still receive a smaller
+// item, so pop() blocks while any lane is empty and not yet closed. A closed
+// lane stops holding back the merge once it drains. pop() returns nullopt
+// after every lane is closed and empty.
+//
+// The heads are kept in a loser tree. Once built, the only head that ever
+// changes is the last winner's: pops take from it, and it is the only lane
+// that can run dry while still open. Its matches are replayed lazily at the
+// next pop, so each pop costs log2(lanes) comparisons and producers never
+// touch the tree.
+template<typename T, typename Compare = std::less<T>>
+class MergeQueue {
+protected:
+    struct Lane {
+        std::deque<T> items;
+        bool closed = false;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::vector<Lane> lanes_;
+    // tree_[0] is the winning lane; tree_[1..k-1] hold the loser of the
+    // match at each internal node. Lane i is leaf i + k.
+    std::vector<size_t> tree_;
+    bool built_ = false;    // tree_ reflects the current heads
+    bool stale_ = false;    // tree_[0]'s head changed since the last replay
+    size_t open_empty_;     // lanes holding back the merge
+    size_t open_lanes_;
+    size_t size_ = 0;
+    const size_t lane_capacity_;
+    Compare comp_;
+
+    // Whether lane a's head should be popped before lane b's. Empty lanes
+    // lose every match; ties go to the lower lane index.
+    bool beats(size_t a, size_t b) const {
+        const auto& qa = lanes_[a].items;
+        const auto& qb = lanes_[b].items;
+        if (qa.empty() || qb.empty()) {
+            return !qa.empty() || (qb.empty() && a < b);
+        }
+        if (comp_(qa.front(), qb.front())) {
+            return true;
+        }
+        if (comp_(qb.front(), qa.front())) {
+            return false;
+        }
+        return a < b;
+    }
+
+    void build() {
+        size_t k = lanes_.size();
+        std::vector<size_t> winners(2 * k);
+        for (size_t i = 0; i < k; ++i) {
+            winners[k + i] = i;
+        }
+        for (size_t node = k - 1; node >= 1; --node) {
+            size_t a = winners[2 * node];
+            size_t b = winners[2 * node + 1];
+            bool a_wins = beats(a, b);
+            winners[node] = a_wins ? a : b;
+            tree_[node] = a_wins ? b : a;
+        }
+        tree_[0] = winners[1];
+    }
+
+    // The winning lane's head changed; replay its matches up to the root.
+    void replay(size_t lane) {
+        size_t winner = lane;
+        for (size_t node = (lane + lanes_.size()) / 2; node > 0; node /= 2) {
+            if (beats(tree_[node], winner)) {
+                std::swap(tree_[node], winner);
+            }
+        }
+        tree_[0] = winner;
+    }
+
+    bool ready() const {
+        return open_empty_ == 0;
+    }
+
+    // Requires ready() and size_ > 0.
+    T take_winner() {
+        if (!built_) {
+            build();
+            built_ = true;
+        } else if (stale_) {
+            replay(tree_[0]);
+        }
+
+        size_t lane = tree_[0];
+        Lane& l = lanes_[lane];
+        bool was_full = l.items.size() >= lane_capacity_;
+        T item = std::move(l.items.front());
+        l.items.pop_front();
+        --size_;
+        if (l.items.empty() && !l.closed) {
+            ++open_empty_;
+        }
+        stale_ = true;
+        if (was_full) {
+            not_full_.notify_all();
+        }
+        if (ready() && size_ > 0) {
+            not_empty_.notify_one();  // Pass readiness on to other consumers
+        }
+        return item;
+    }
+
+    template<typename U>
+    void enqueue(size_t lane, U&& item) {
+        Lane& l = lanes_[lane];
+        l.items.push_back(std::forward<U>(item));
+        ++size_;
+        if (l.items.size() == 1) {
+            --open_empty_;
+            not_empty_.notify_one();
+        }
+    }
+
+public:
+    explicit MergeQueue(size_t lanes,
+                        size_t lane_capacity = std::numeric_limits<size_t>::max(),
+                        Compare comp = Compare())
+        : lanes_(lanes > 0 ? lanes : 1),
+          tree_(lanes_.size()),
+          open_empty_(lanes_.size()),
+          open_lanes_(lanes_.size()),
+          lane_capacity_(lane_capacity),
+          comp_(std::move(comp)) {}
+
+    ~MergeQueue() {
+        close();
+    }
+
+    MergeQueue(const MergeQueue&) = delete;
+    MergeQueue& operator=(const MergeQueue&) = delete;
+
+    // Items pushed to one lane must not decrease. Returns false if the lane
+    // is closed.
+    template<typename U>
+    bool push(size_t lane, U&& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Lane& l = lanes_.at(lane);
+
+        not_full_.wait(lock, [&] {
+            return l.items.size() < lane_capacity_ || l.closed;
+        });
+
+        if (l.closed) {
+            return false;
+        }
+
+        enqueue(lane, std::forward<U>(item));
+        return true;
+    }
+
+    template<typename Rep, typename Period>
+    bool try_push(size_t lane, const T& item,
+                  const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Lane& l = lanes_.at(lane);
+
+        if (!not_full_.wait_for(lock, timeout, [&] {
+            return l.items.size() < lane_capacity_ || l.closed;
+        })) {
+            return false;
+        }
+
+        if (l.closed) {
+            return false;
+        }
+
+        enqueue(lane, item);
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        not_empty_.wait(lock, [this] {
+            return ready();
+        });
+
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+
+        return take_winner();
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<T> try_pop(const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!not_empty_.wait_for(lock, timeout, [this] {
+            return ready();
+        })) {
+            return std::nullopt;
+        }
+
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+
+        return take_winner();
+    }
+
+    // The lane's producer is done; its remaining items still merge.
+    void close(size_t lane) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Lane& l = lanes_.at(lane);
+        if (l.closed) {
+            return;
+        }
+        l.closed = true;
+        --open_lanes_;
+        if (l.items.empty()) {
+            --open_empty_;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    void close() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (auto& l : lanes_) {
+            l.closed = true;
+        }
+        open_lanes_ = 0;
+        open_empty_ = 0;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    // Queue state
+    bool is_closed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return open_lanes_ == 0;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_ == 0;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    size_t lanes() const {
+        return lanes_.size();
+    }
+
+    size_t lane_capacity() const {
+        return lane_capacity_;
+    }
+};
+
+} // namespace async_queue
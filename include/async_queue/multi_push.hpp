@@ -0,0 +1,222 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+namespace async_queue {
+
+// One item bound for one queue, as part of a PushTransaction.
+template<typename T>
+struct PushEntry {
+    AsyncQueue<T>* queue;
+    T item;
+};
+
+template<typename T, typename U>
+PushEntry<T> push_entry(AsyncQueue<T>& queue, U&& item) {
+    return PushEntry<T>{&queue, T(std::forward<U>(item))};
+}
+
+// A set of items that must land in their queues all together or not at
+// all, e.g. a work item and its audit record. Pass it to push_all() or
+// try_push_all(). If the push fails, the items stay in the transaction and
+// can be read back with item<I>().
+template<typename... Ts>
+class PushTransaction {
+public:
+    explicit PushTransaction(PushEntry<Ts>... entries)
+        : entries_(std::move(entries)...) {}
+
+    template<size_t I>
+    auto& item() {
+        return std::get<I>(entries_).item;
+    }
+
+    bool committed() const {
+        return committed_;
+    }
+
+private:
+    std::tuple<PushEntry<Ts>...> entries_;
+    bool committed_ = false;
+
+    friend struct detail::MultiPush;
+};
+
+template<typename... Ts>
+PushTransaction<Ts...> make_push_transaction(PushEntry<Ts>... entries) {
+    return PushTransaction<Ts...>(std::move(entries)...);
+}
+
+namespace detail {
+
+// Implements push_all. Locks every involved queue in address order (so two
+// concurrent transactions cannot deadlock), checks that each is open and
+// has room for all of its items, and commits only if all do. Otherwise it
+// drops every lock and waits for room on the queue that was short, so no
+// lock is ever held while blocking.
+struct MultiPush {
+    enum class Check {
+        ready,
+        blocked,
+        failed,
+    };
+
+    template<typename... Ts, typename Deadline>
+    static bool run(PushTransaction<Ts...>& tx, const Deadline* deadline) {
+        constexpr size_t N = sizeof...(Ts);
+        if (tx.committed_) {
+            return false;
+        }
+
+        std::array<const void*, N> queues = addresses(tx, std::index_sequence_for<Ts...>{});
+        std::array<size_t, N> needed{};
+        for (size_t i = 0; i < N; ++i) {
+            needed[i] = static_cast<size_t>(std::count(queues.begin(), queues.end(), queues[i]));
+        }
+        std::array<std::mutex*, N> mutexes = mutexes_of(tx, std::index_sequence_for<Ts...>{});
+        std::sort(mutexes.begin(), mutexes.end(), std::less<std::mutex*>());
+        size_t distinct = static_cast<size_t>(
+            std::unique(mutexes.begin(), mutexes.end()) - mutexes.begin());
+
+        for (;;) {
+            for (size_t i = 0; i < distinct; ++i) {
+                mutexes[i]->lock();
+            }
+
+            size_t blocked = N;
+            Check check = check_all(tx, needed, blocked, std::index_sequence_for<Ts...>{});
+            if (check == Check::ready) {
+                commit(tx, std::index_sequence_for<Ts...>{});
+                tx.committed_ = true;
+            }
+
+            for (size_t i = distinct; i-- > 0;) {
+                mutexes[i]->unlock();
+            }
+
+            if (check == Check::ready) {
+                return true;
+            }
+            if (check == Check::failed) {
+                return false;
+            }
+            if (!wait_any(tx, blocked, needed[blocked], deadline,
+                          std::index_sequence_for<Ts...>{})) {
+                return false;
+            }
+        }
+    }
+
+private:
+    // Transactions push at admission priority 0, so slots reserved for
+    // higher priorities never count towards their room.
+    template<typename T>
+    static bool never_fits(AsyncQueue<T>& queue, size_t needed) {
+        return needed > queue.limit_for(0);
+    }
+
+    template<typename T>
+    static Check check(AsyncQueue<T>& queue, size_t needed) {
+        if (queue.closed_ || never_fits(queue, needed)) {
+            return Check::failed;
+        }
+        return can_enter(queue, needed) ? Check::ready : Check::blocked;
+    }
+
+    template<typename T>
+    static bool can_enter(AsyncQueue<T>& queue, size_t needed) {
+        return queue.has_room(0, needed) &&
+               (queue.fairness_ == Fairness::barging || queue.parked_producers_.empty());
+    }
+
+    template<typename... Ts, size_t... I>
+    static std::array<const void*, sizeof...(Ts)>
+    addresses(PushTransaction<Ts...>& tx, std::index_sequence<I...>) {
+        return {{static_cast<const void*>(std::get<I>(tx.entries_).queue)...}};
+    }
+
+    template<typename... Ts, size_t... I>
+    static std::array<std::mutex*, sizeof...(Ts)>
+    mutexes_of(PushTransaction<Ts...>& tx, std::index_sequence<I...>) {
+        return {{&std::get<I>(tx.entries_).queue->mutex_...}};
+    }
+
+    template<typename... Ts, size_t N, size_t... I>
+    static Check check_all(PushTransaction<Ts...>& tx, const std::array<size_t, N>& needed,
+                           size_t& blocked, std::index_sequence<I...>) {
+        Check result = Check::ready;
+        auto one = [&](size_t index, Check c) {
+            if (result == Check::failed) {
+                return;
+            }
+            if (c == Check::failed) {
+                result = Check::failed;
+            } else if (c == Check::blocked && result == Check::ready) {
+                result = Check::blocked;
+                blocked = index;
+            }
+        };
+        (one(I, check(*std::get<I>(tx.entries_).queue, needed[I])), ...);
+        return result;
+    }
+
+    template<typename... Ts, size_t... I>
+    static void commit(PushTransaction<Ts...>& tx, std::index_sequence<I...>) {
+        (std::get<I>(tx.entries_).queue->deliver(std::move(std::get<I>(tx.entries_).item)), ...);
+    }
+
+    template<typename T, typename Deadline>
+    static bool wait_room(AsyncQueue<T>& queue, size_t needed, const Deadline* deadline) {
+        std::unique_lock<std::mutex> lock(queue.mutex_);
+        ++queue.room_watchers_;
+        auto ready = [&] {
+            return queue.closed_ || never_fits(queue, needed) || can_enter(queue, needed);
+        };
+        bool ok = true;
+        if (deadline) {
+            ok = queue.cv_.wait_until(lock, *deadline, ready);
+        } else {
+            queue.cv_.wait(lock, ready);
+        }
+        --queue.room_watchers_;
+        return ok;
+    }
+
+    template<typename... Ts, typename Deadline, size_t... I>
+    static bool wait_any(PushTransaction<Ts...>& tx, size_t index, size_t needed,
+                         const Deadline* deadline, std::index_sequence<I...>) {
+        bool ok = true;
+        ((index == I ? (ok = wait_room(*std::get<I>(tx.entries_).queue, needed, deadline))
+                     : false), ...);
+        return ok;
+    }
+};
+
+} // namespace detail
+
+// Push every item of the transaction, waiting for room in all queues.
+// Returns false, pushing nothing, if any queue is closed (or the
+// transaction needs more slots in a queue than a priority-0 push may fill,
+// see reserve_capacity()).
+template<typename... Ts>
+bool push_all(PushTransaction<Ts...>& tx) {
+    const std::chrono::steady_clock::time_point* no_deadline = nullptr;
+    return detail::MultiPush::run(tx, no_deadline);
+}
+
+// Like push_all, but gives up, pushing nothing, after timeout.
+template<typename... Ts, typename Rep, typename Period>
+bool try_push_all(PushTransaction<Ts...>& tx,
+                  const std::chrono::duration<Rep, Period>& timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    return detail::MultiPush::run(tx, &deadline);
+}
+
+} // namespace async_queue
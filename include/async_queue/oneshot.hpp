@@ -0,0 +1,177 @@
+#pragma once
+#include "async_queue/futex.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace async_queue {
+
+// Single-value channel: one push, at most one successful pop.
+//
+// The value lives inline next to a single 32-bit state word, and waiting
+// goes straight to a futex on that word (with a sleep-and-recheck fallback
+// off Linux), so there is no deque, mutex or condition variable. The wake
+// syscall is skipped unless a receiver is actually blocked. For small T the
+// whole channel fits in one cache line.
+//
+// close() means the sender went away: a pending pop() returns nullopt.
+// A value pushed before close() can still be popped.
+template<typename T>
+class alignas(64) Oneshot {
+protected:
+    enum : uint32_t {
+        EMPTY = 0,
+        WRITING = 1,   // sender is constructing the value
+        READY = 2,
+        CLOSED = 3,
+        TAKEN = 4,     // value was popped
+        STATE_MASK = 7,
+        WAITER = 8,    // a receiver may be blocked in futex_wait
+    };
+
+    std::atomic<uint32_t> state_{EMPTY};
+    alignas(T) unsigned char storage_[sizeof(T)];
+
+    T* value() {
+        return std::launder(reinterpret_cast<T*>(storage_));
+    }
+
+    // Move from EMPTY to `to`, keeping the waiter bit. False if the
+    // channel was not empty.
+    bool leave_empty(uint32_t to, uint32_t& previous) {
+        previous = state_.load(std::memory_order_relaxed);
+        while ((previous & STATE_MASK) == EMPTY) {
+            if (state_.compare_exchange_weak(previous, to | (previous & WAITER),
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void publish(uint32_t to) {
+        if (state_.exchange(to, std::memory_order_acq_rel) & WAITER) {
+            detail::futex_wake_all(&state_);
+        }
+    }
+
+    // One attempt to take the value. Sets done once the outcome is final.
+    std::optional<T> poll(bool& done, uint32_t& observed) {
+        uint32_t s = state_.load(std::memory_order_acquire);
+        for (;;) {
+            switch (s & STATE_MASK) {
+            case READY:
+                if (state_.compare_exchange_weak(s, TAKEN, std::memory_order_acquire,
+                                                 std::memory_order_acquire)) {
+                    done = true;
+                    std::optional<T> result(std::move(*value()));
+                    value()->~T();
+                    return result;
+                }
+                continue;
+            case CLOSED:
+            case TAKEN:
+                done = true;
+                return std::nullopt;
+            default:
+                // Announce the waiter before sleeping on the exact word.
+                if (!(s & WAITER) &&
+                    !state_.compare_exchange_weak(s, s | WAITER, std::memory_order_acquire,
+                                                  std::memory_order_acquire)) {
+                    continue;
+                }
+                observed = s | WAITER;
+                done = false;
+                return std::nullopt;
+            }
+        }
+    }
+
+public:
+    Oneshot() = default;
+
+    ~Oneshot() {
+        if ((state_.load(std::memory_order_acquire) & STATE_MASK) == READY) {
+            value()->~T();
+        }
+    }
+
+    Oneshot(const Oneshot&) = delete;
+    Oneshot& operator=(const Oneshot&) = delete;
+
+    // Send the value. Returns false if a value was already sent or the
+    // channel is closed. If constructing the value throws, the channel is
+    // left empty, so the sender can retry or close().
+    template<typename U>
+    bool push(U&& item) {
+        uint32_t previous;
+        if (!leave_empty(WRITING, previous)) {
+            return false;
+        }
+        try {
+            ::new (static_cast<void*>(storage_)) T(std::forward<U>(item));
+        } catch (...) {
+            publish(EMPTY);  // Receivers that saw WRITING re-check
+            throw;
+        }
+        publish(READY);
+        return true;
+    }
+
+    // Wait for the value. Returns nullopt if the channel was closed without
+    // one, or another receiver already took it.
+    std::optional<T> pop() {
+        for (;;) {
+            bool done = false;
+            uint32_t observed = 0;
+            auto result = poll(done, observed);
+            if (done) {
+                return result;
+            }
+            detail::futex_wait(&state_, observed);
+        }
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<T> try_pop(const std::chrono::duration<Rep, Period>& timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (;;) {
+            bool done = false;
+            uint32_t observed = 0;
+            auto result = poll(done, observed);
+            if (done) {
+                return result;
+            }
+            auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline - std::chrono::steady_clock::now());
+            if (remaining <= std::chrono::nanoseconds::zero()) {
+                return std::nullopt;
+            }
+            detail::futex_wait(&state_, observed, &remaining);
+        }
+    }
+
+    // The sender is gone without sending. No effect once a value was sent.
+    void close() {
+        uint32_t previous;
+        if (leave_empty(CLOSED, previous) && (previous & WAITER)) {
+            detail::futex_wake_all(&state_);
+        }
+    }
+
+    bool is_closed() const {
+        return (state_.load(std::memory_order_acquire) & STATE_MASK) == CLOSED;
+    }
+
+    // A value was sent and not yet popped.
+    bool ready() const {
+        return (state_.load(std::memory_order_acquire) & STATE_MASK) == READY;
+    }
+};
+
+} // namespace async_queue
@@ -0,0 +1,248 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace async_queue {
+
+// How long items wait before their effective priority rises.
+struct AgingPolicy {
+    size_t levels = 8;  // priorities 0 (lowest) .. levels - 1 (highest)
+    // Waiting this long raises an item's effective priority by one level.
+    // Zero disables aging.
+    std::chrono::steady_clock::duration interval = std::chrono::milliseconds(100);
+};
+
+// Wait times of popped items, bucketed by powers of two microseconds:
+// buckets[0] counts waits under 2us, buckets[i] waits in [2^i, 2^(i+1)) us.
+struct WaitHistogram {
+    std::array<uint64_t, 32> buckets{};
+    uint64_t count = 0;
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds max{0};
+
+    void record(std::chrono::nanoseconds wait) {
+        auto us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(wait).count());
+        size_t bucket = 0;
+        while (us > 1 && bucket + 1 < buckets.size()) {
+            us >>= 1;
+            ++bucket;
+        }
+        ++buckets[bucket];
+        ++count;
+        total += wait;
+        if (wait > max) {
+            max = wait;
+        }
+    }
+};
+
+// Bounded priority queue with starvation-free aging.
+//
+// Items live in one FIFO per priority level, so the front of each level is
+// its oldest item and therefore has the highest effective priority in that
+// level:
+//
+//     effective = min(levels - 1, priority + waited / interval)
+//
+// pop() compares only the level fronts, which makes aging lazy: nothing is
+// re-sorted as time passes and pop costs O(levels) regardless of depth.
+// Ties go to the item that has waited longest.
+template<typename T>
+class PriorityAsyncQueue {
+protected:
+    using Clock = std::chrono::steady_clock;
+
+    struct Node {
+        T item;
+        Clock::time_point enqueued;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::deque<Node>> levels_;
+    std::vector<WaitHistogram> histograms_;
+    size_t size_ = 0;
+    bool closed_ = false;
+    const size_t capacity_;
+    const AgingPolicy policy_;
+
+    size_t clamp(size_t priority) const {
+        return priority < levels_.size() ? priority : levels_.size() - 1;
+    }
+
+    size_t effective(size_t level, Clock::time_point now) const {
+        const Node& front = levels_[level].front();
+        if (policy_.interval == Clock::duration::zero()) {
+            return level;
+        }
+        auto boost = static_cast<size_t>((now - front.enqueued) / policy_.interval);
+        return std::min(levels_.size() - 1, level + boost);
+    }
+
+    // Requires size_ > 0.
+    T take_best() {
+        auto now = Clock::now();
+        size_t best = levels_.size();
+        size_t best_priority = 0;
+        for (size_t level = levels_.size(); level-- > 0;) {
+            if (levels_[level].empty()) {
+                continue;
+            }
+            size_t priority = effective(level, now);
+            if (best == levels_.size() || priority > best_priority ||
+                (priority == best_priority &&
+                 levels_[level].front().enqueued < levels_[best].front().enqueued)) {
+                best = level;
+                best_priority = priority;
+            }
+        }
+
+        Node& node = levels_[best].front();
+        histograms_[best].record(now - node.enqueued);
+        T item = std::move(node.item);
+        levels_[best].pop_front();
+        --size_;
+        return item;
+    }
+
+    template<typename U>
+    void enqueue(U&& item, size_t priority) {
+        levels_[clamp(priority)].push_back(Node{T(std::forward<U>(item)), Clock::now()});
+        ++size_;
+    }
+
+public:
+    explicit PriorityAsyncQueue(AgingPolicy policy = AgingPolicy(),
+                                size_t capacity = std::numeric_limits<size_t>::max())
+        : levels_(policy.levels > 0 ? policy.levels : 1),
+          histograms_(levels_.size()),
+          capacity_(capacity),
+          policy_(policy) {}
+
+    ~PriorityAsyncQueue() {
+        close();
+    }
+
+    PriorityAsyncQueue(const PriorityAsyncQueue&) = delete;
+    PriorityAsyncQueue& operator=(const PriorityAsyncQueue&) = delete;
+
+    // Priorities above levels - 1 are treated as levels - 1.
+    template<typename U>
+    bool push(U&& item, size_t priority) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        cv_.wait(lock, [this] {
+            return size_ < capacity_ || closed_;
+        });
+
+        if (closed_) {
+            return false;
+        }
+
+        enqueue(std::forward<U>(item), priority);
+        cv_.notify_one();
+        return true;
+    }
+
+    template<typename Rep, typename Period>
+    bool try_push(const T& item, size_t priority,
+                  const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!cv_.wait_for(lock, timeout, [this] {
+            return size_ < capacity_ || closed_;
+        })) {
+            return false;
+        }
+
+        if (closed_) {
+            return false;
+        }
+
+        enqueue(item, priority);
+        cv_.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        cv_.wait(lock, [this] {
+            return size_ > 0 || closed_;
+        });
+
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+
+        T item = take_best();
+        cv_.notify_one();
+        return item;
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<T> try_pop(const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!cv_.wait_for(lock, timeout, [this] {
+            return size_ > 0 || closed_;
+        })) {
+            return std::nullopt;
+        }
+
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+
+        T item = take_best();
+        cv_.notify_one();
+        return item;
+    }
+
+    void close() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        closed_ = true;
+        cv_.notify_all();
+    }
+
+    // Queue state
+    bool is_closed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_ == 0;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    size_t levels() const {
+        return levels_.size();
+    }
+
+    // Wait-time distribution of items pushed at the given priority.
+    WaitHistogram wait_histogram(size_t priority) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return histograms_[clamp(priority)];
+    }
+};
+
+} // namespace async_queue
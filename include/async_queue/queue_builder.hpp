@@ -0,0 +1,192 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include "async_queue/priority_queue.hpp"
+#include "async_queue/spsc_queue.hpp"
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace async_queue {
+
+// Picks a queue implementation at compile time from a description of how
+// it will be used:
+//
+//   using namespace async_queue::opt;
+//   using Queue = make_queue_type<Job>::producers<single>::consumers<single>
+//                     ::bounded<4096>::wait<spin_then_park>::type;
+//   Queue queue;
+//
+// Options, each given at most once and in any order (values live in
+// async_queue::opt):
+//   producers<single | multi>       default multi
+//   consumers<single | multi>       default multi
+//   bounded<N>                      default unbounded
+//   wait<park | spin_then_park>     default park
+//   order<by_arrival | by_priority> default by_arrival
+//
+// Resolution, most specialized first:
+//   order<by_priority>                        -> PriorityAsyncQueue
+//   single producer, single consumer, bounded -> SpscQueue
+//   anything else                             -> AsyncQueue
+//
+// Every result is default-constructible with the builder's capacity and
+// offers push(item), try_push(item, timeout), pop(), try_pop(timeout),
+// close(), is_closed(), empty(), size() and capacity(), so call sites
+// written against one keep compiling against another. The backend is
+// available as ::backend. Options no backend can honour together, such as
+// spin_then_park on a mutex-based queue, fail with a static_assert once
+// the type is used.
+
+namespace opt {
+
+// Builder option values; park and spin_then_park come from spsc_queue.hpp.
+struct single {};
+struct multi {};
+struct by_arrival {};
+struct by_priority {};
+
+} // namespace opt
+
+namespace detail {
+
+struct unset {};
+
+inline constexpr size_t unbounded_capacity = std::numeric_limits<size_t>::max();
+
+template<typename Current, typename Value, typename... Allowed>
+struct set_option {
+    static_assert(std::is_same_v<Current, unset>, "queue option given more than once");
+    static_assert((std::is_same_v<Value, Allowed> || ...),
+                  "unsupported value for this queue option");
+    using type = Value;
+};
+
+template<typename Current, typename Value>
+using side_option = typename set_option<Current, Value, opt::single, opt::multi>::type;
+
+template<typename Current, typename Value>
+using wait_option = typename set_option<Current, Value, opt::park, opt::spin_then_park>::type;
+
+template<typename Current, typename Value>
+using order_option =
+    typename set_option<Current, Value, opt::by_arrival, opt::by_priority>::type;
+
+template<size_t Current, size_t N>
+struct set_capacity {
+    static_assert(Current == 0, "bounded<> given more than once");
+    static_assert(N > 0, "bounded<> needs a capacity of at least 1");
+    static constexpr size_t value = N;
+};
+
+template<typename Option, typename Default>
+using or_default = std::conditional_t<std::is_same_v<Option, unset>, Default, Option>;
+
+// PriorityAsyncQueue with the common push/try_push shape: the priority
+// comes last and defaults to 0.
+template<typename T>
+class PriorityBackend : public PriorityAsyncQueue<T> {
+public:
+    explicit PriorityBackend(size_t capacity)
+        : PriorityAsyncQueue<T>(AgingPolicy(), capacity) {}
+
+    template<typename U>
+    bool push(U&& item, size_t priority = 0) {
+        return PriorityAsyncQueue<T>::push(std::forward<U>(item), priority);
+    }
+
+    template<typename Rep, typename Period>
+    bool try_push(const T& item, const std::chrono::duration<Rep, Period>& timeout,
+                  size_t priority = 0) {
+        return PriorityAsyncQueue<T>::try_push(item, priority, timeout);
+    }
+};
+
+template<typename T, typename Producers, typename Consumers, size_t Capacity, typename Wait,
+         typename Order>
+struct select_queue {
+    static constexpr bool prioritized = std::is_same_v<Order, opt::by_priority>;
+    static constexpr bool spsc = std::is_same_v<Producers, opt::single> &&
+                                 std::is_same_v<Consumers, opt::single> &&
+                                 Capacity != unbounded_capacity;
+
+    using type = std::conditional_t<prioritized, PriorityBackend<T>,
+                 std::conditional_t<spsc, SpscQueue<T, Wait>, AsyncQueue<T>>>;
+};
+
+template<typename Q, typename T, typename = void>
+struct has_queue_interface : std::false_type {};
+
+template<typename Q, typename T>
+struct has_queue_interface<Q, T, std::void_t<
+    decltype(bool(std::declval<Q&>().push(std::declval<T>()))),
+    decltype(bool(std::declval<Q&>().try_push(std::declval<const T&>(),
+                                               std::chrono::milliseconds(1)))),
+    decltype(std::optional<T>(std::declval<Q&>().pop())),
+    decltype(std::optional<T>(std::declval<Q&>().try_pop(std::chrono::milliseconds(1)))),
+    decltype(std::declval<Q&>().close()),
+    decltype(bool(std::declval<const Q&>().is_closed())),
+    decltype(bool(std::declval<const Q&>().empty())),
+    decltype(size_t(std::declval<const Q&>().size())),
+    decltype(size_t(std::declval<const Q&>().capacity()))>> : std::true_type {};
+
+} // namespace detail
+
+// The queue a builder resolved to. Only instantiated when used, so a
+// half-built chain never trips the checks below.
+template<typename T, typename Producers, typename Consumers, size_t Capacity, typename Wait,
+         typename Order>
+class BuiltQueue
+    : public detail::select_queue<T, Producers, Consumers, Capacity, Wait, Order>::type {
+    using select = detail::select_queue<T, Producers, Consumers, Capacity, Wait, Order>;
+
+    static_assert(!std::is_same_v<Wait, opt::spin_then_park> ||
+                      (select::spsc && !select::prioritized),
+                  "wait<spin_then_park> needs producers<single>, consumers<single>, bounded<N> "
+                  "and arrival order");
+
+public:
+    using backend = typename select::type;
+
+    static_assert(detail::has_queue_interface<backend, T>::value,
+                  "backend lacks the common queue interface");
+
+    BuiltQueue() : backend(Capacity) {}
+};
+
+template<typename T, typename Producers = detail::unset, typename Consumers = detail::unset,
+         size_t Capacity = 0, typename Wait = detail::unset, typename Order = detail::unset>
+struct QueueBuilder {
+    template<typename P>
+    using producers = QueueBuilder<T, detail::side_option<Producers, P>, Consumers, Capacity,
+                                   Wait, Order>;
+
+    template<typename C>
+    using consumers = QueueBuilder<T, Producers, detail::side_option<Consumers, C>, Capacity,
+                                   Wait, Order>;
+
+    template<size_t N>
+    using bounded = QueueBuilder<T, Producers, Consumers, detail::set_capacity<Capacity, N>::value,
+                                 Wait, Order>;
+
+    template<typename W>
+    using wait = QueueBuilder<T, Producers, Consumers, Capacity, detail::wait_option<Wait, W>,
+                              Order>;
+
+    template<typename O>
+    using order = QueueBuilder<T, Producers, Consumers, Capacity, Wait,
+                               detail::order_option<Order, O>>;
+
+    using type = BuiltQueue<T, detail::or_default<Producers, opt::multi>,
+                            detail::or_default<Consumers, opt::multi>,
+                            (Capacity > 0 ? Capacity : detail::unbounded_capacity),
+                            detail::or_default<Wait, opt::park>,
+                            detail::or_default<Order, opt::by_arrival>>;
+};
+
+template<typename T>
+using make_queue_type = QueueBuilder<T>;
+
+} // namespace async_queue
@@ -0,0 +1,98 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace async_queue {
+
+// Pool of ready-to-use AsyncQueues for short-lived, per-request queues.
+//
+// acquire() hands out an idle queue (or builds one if none is idle) as a
+// unique_ptr whose deleter returns it to the pool. Returned queues are
+// closed and reset(), so they come back open and empty without their
+// mutex, condition variables or storage being rebuilt. Threads still
+// parked in a returned queue are woken, and the release waits for them to
+// leave. Once warmed up, an
+// acquire/release round trip is two uncontended lock operations and no
+// allocation. The pool must outlive the queues it hands out.
+template<typename T>
+class QueuePool {
+public:
+    class Releaser {
+        QueuePool* pool_ = nullptr;
+
+    public:
+        Releaser() = default;
+        explicit Releaser(QueuePool* pool) : pool_(pool) {}
+
+        void operator()(AsyncQueue<T>* queue) const {
+            if (pool_) {
+                pool_->release(queue);
+            } else {
+                delete queue;
+            }
+        }
+    };
+
+    using Handle = std::unique_ptr<AsyncQueue<T>, Releaser>;
+
+protected:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<AsyncQueue<T>>> idle_;
+    const size_t queue_capacity_;
+    const Fairness fairness_;
+    const size_t max_idle_;
+
+    void release(AsyncQueue<T>* queue) {
+        std::unique_ptr<AsyncQueue<T>> owned(queue);
+        // Neither recycling nor deleting is safe while a woken thread may
+        // still re-take the queue's mutex.
+        owned->wait_until_idle();
+        owned->reset();  // Cannot fail once idle
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < max_idle_) {
+            idle_.push_back(std::move(owned));
+        }
+    }
+
+public:
+    // Queues are built with the given capacity and fairness. At most
+    // max_idle returned queues are kept; extras are destroyed.
+    explicit QueuePool(size_t queue_capacity = std::numeric_limits<size_t>::max(),
+                       Fairness fairness = Fairness::barging,
+                       size_t max_idle = 64)
+        : queue_capacity_(queue_capacity), fairness_(fairness), max_idle_(max_idle) {
+        idle_.reserve(max_idle_);
+    }
+
+    QueuePool(const QueuePool&) = delete;
+    QueuePool& operator=(const QueuePool&) = delete;
+
+    Handle acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                AsyncQueue<T>* queue = idle_.back().release();
+                idle_.pop_back();
+                return Handle(queue, Releaser(this));
+            }
+        }
+        return Handle(new AsyncQueue<T>(queue_capacity_, fairness_), Releaser(this));
+    }
+
+    // Build queues ahead of time so the first acquires do not allocate.
+    void reserve(size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (idle_.size() < count && idle_.size() < max_idle_) {
+            idle_.push_back(std::make_unique<AsyncQueue<T>>(queue_capacity_, fairness_));
+        }
+    }
+
+    size_t idle() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return idle_.size();
+    }
+};
+
+} // namespace async_queue
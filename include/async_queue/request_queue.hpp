@@ -0,0 +1,333 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace async_queue {
+
+namespace detail {
+
+// Pool of reply slots shared by the callers and responders of a
+// RequestQueue. Slots live in a deque so their addresses are stable, and
+// are recycled through a free list, so steady-state calls never allocate.
+// A slot is recycled once both its caller and its responder let go of it;
+// the generation number makes any handle to a recycled slot inert.
+template<typename Resp>
+class ReplySlab {
+    struct Slot {
+        std::condition_variable cv;
+        std::optional<Resp> value;
+        uint32_t generation = 0;
+        bool caller = false;     // PendingReply still attached
+        bool responder = false;  // Responder still attached
+    };
+
+    mutable std::mutex mutex_;
+    std::deque<Slot> slots_;
+    std::vector<uint32_t> free_;
+
+    Slot* get(uint32_t index, uint32_t generation) {
+        Slot& slot = slots_[index];
+        return slot.generation == generation ? &slot : nullptr;
+    }
+
+    void recycle_if_unused(Slot& slot, uint32_t index) {
+        if (!slot.caller && !slot.responder) {
+            slot.value.reset();
+            ++slot.generation;
+            free_.push_back(index);
+        }
+    }
+
+public:
+    // Returns the slot index; the generation is written to generation.
+    uint32_t acquire(uint32_t& generation) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint32_t index;
+        if (free_.empty()) {
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        } else {
+            index = free_.back();
+            free_.pop_back();
+        }
+        Slot& slot = slots_[index];
+        slot.caller = true;
+        slot.responder = true;
+        generation = slot.generation;
+        return index;
+    }
+
+    // Deliver a reply, or just detach the responder if value is null.
+    void fulfill(uint32_t index, uint32_t generation, std::optional<Resp>&& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot* slot = get(index, generation);
+        if (!slot || !slot->responder) {
+            return;
+        }
+        slot->responder = false;
+        if (slot->caller) {
+            slot->value = std::move(value);
+            slot->cv.notify_one();
+        }
+        recycle_if_unused(*slot, index);
+    }
+
+    // Wait for the reply. Returns nullopt if the responder went away
+    // without replying.
+    std::optional<Resp> wait(uint32_t index, uint32_t generation) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Slot* slot = get(index, generation);
+        if (!slot) {
+            return std::nullopt;
+        }
+        slot->cv.wait(lock, [slot] {
+            return !slot->responder;
+        });
+        return take(*slot, index);
+    }
+
+    // Like wait, but sets timed_out and keeps the slot attached if the
+    // reply does not arrive in time.
+    template<typename Rep, typename Period>
+    std::optional<Resp> wait_for(uint32_t index, uint32_t generation,
+                                 const std::chrono::duration<Rep, Period>& timeout,
+                                 bool& timed_out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Slot* slot = get(index, generation);
+        if (!slot) {
+            return std::nullopt;
+        }
+        timed_out = !slot->cv.wait_for(lock, timeout, [slot] {
+            return !slot->responder;
+        });
+        if (timed_out) {
+            return std::nullopt;
+        }
+        return take(*slot, index);
+    }
+
+    // The caller gave up on the reply.
+    void abandon(uint32_t index, uint32_t generation) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot* slot = get(index, generation);
+        if (!slot || !slot->caller) {
+            return;
+        }
+        slot->caller = false;
+        recycle_if_unused(*slot, index);
+    }
+
+    size_t in_use() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return slots_.size() - free_.size();
+    }
+
+private:
+    std::optional<Resp> take(Slot& slot, uint32_t index) {
+        std::optional<Resp> value = std::move(slot.value);
+        slot.caller = false;
+        recycle_if_unused(slot, index);
+        return value;
+    }
+};
+
+} // namespace detail
+
+// Request/reply over an AsyncQueue.
+//
+// call() enqueues a request and returns a PendingReply, a small move-only
+// future. The consumer pops an Envelope and answers through its Responder.
+// Reply state comes from a pooled slab instead of a std::promise per call,
+// so a warmed-up queue does not allocate per round trip.
+//
+// A caller that times out or drops its PendingReply just detaches. The slot
+// is recycled when the responder replies or is destroyed, so abandoned
+// calls do not leak. The RequestQueue must outlive its PendingReply and
+// Responder objects.
+template<typename Req, typename Resp>
+class RequestQueue {
+    using Slab = detail::ReplySlab<Resp>;
+
+public:
+    class Responder {
+        Slab* slab_ = nullptr;
+        uint32_t index_ = 0;
+        uint32_t generation_ = 0;
+
+        friend class RequestQueue;
+        Responder(Slab* slab, uint32_t index, uint32_t generation)
+            : slab_(slab), index_(index), generation_(generation) {}
+
+    public:
+        Responder() = default;
+        Responder(Responder&& other) noexcept
+            : slab_(std::exchange(other.slab_, nullptr)),
+              index_(other.index_), generation_(other.generation_) {}
+        Responder& operator=(Responder&& other) noexcept {
+            if (this != &other) {
+                drop();
+                slab_ = std::exchange(other.slab_, nullptr);
+                index_ = other.index_;
+                generation_ = other.generation_;
+            }
+            return *this;
+        }
+        Responder(const Responder&) = delete;
+        Responder& operator=(const Responder&) = delete;
+
+        // Destroying a Responder without replying tells the caller no reply
+        // is coming.
+        ~Responder() {
+            drop();
+        }
+
+        // Complete the call. Only the first reply counts; a reply to an
+        // abandoned call is discarded.
+        void reply(Resp value) {
+            if (slab_) {
+                std::exchange(slab_, nullptr)->fulfill(index_, generation_, std::move(value));
+            }
+        }
+
+        bool valid() const {
+            return slab_ != nullptr;
+        }
+
+    private:
+        void drop() {
+            if (slab_) {
+                std::exchange(slab_, nullptr)->fulfill(index_, generation_, std::nullopt);
+            }
+        }
+    };
+
+    class PendingReply {
+        Slab* slab_ = nullptr;
+        uint32_t index_ = 0;
+        uint32_t generation_ = 0;
+
+        friend class RequestQueue;
+        PendingReply(Slab* slab, uint32_t index, uint32_t generation)
+            : slab_(slab), index_(index), generation_(generation) {}
+
+    public:
+        PendingReply() = default;
+        PendingReply(PendingReply&& other) noexcept
+            : slab_(std::exchange(other.slab_, nullptr)),
+              index_(other.index_), generation_(other.generation_) {}
+        PendingReply& operator=(PendingReply&& other) noexcept {
+            if (this != &other) {
+                abandon();
+                slab_ = std::exchange(other.slab_, nullptr);
+                index_ = other.index_;
+                generation_ = other.generation_;
+            }
+            return *this;
+        }
+        PendingReply(const PendingReply&) = delete;
+        PendingReply& operator=(const PendingReply&) = delete;
+
+        ~PendingReply() {
+            abandon();
+        }
+
+        // False if the request was never queued or the reply was taken.
+        bool valid() const {
+            return slab_ != nullptr;
+        }
+
+        // Wait for the reply. Returns nullopt if the request was not
+        // queued or was dropped without a reply.
+        std::optional<Resp> get() {
+            if (!slab_) {
+                return std::nullopt;
+            }
+            return std::exchange(slab_, nullptr)->wait(index_, generation_);
+        }
+
+        // Like get, but gives up after timeout. On timeout the reply stays
+        // pending and can still be waited for; destroying the PendingReply
+        // abandons it.
+        template<typename Rep, typename Period>
+        std::optional<Resp> try_get(const std::chrono::duration<Rep, Period>& timeout) {
+            if (!slab_) {
+                return std::nullopt;
+            }
+            bool timed_out = false;
+            auto value = slab_->wait_for(index_, generation_, timeout, timed_out);
+            if (!timed_out) {
+                slab_ = nullptr;
+            }
+            return value;
+        }
+
+        void abandon() {
+            if (slab_) {
+                std::exchange(slab_, nullptr)->abandon(index_, generation_);
+            }
+        }
+    };
+
+    struct Envelope {
+        Req request;
+        Responder responder;
+    };
+
+protected:
+    Slab slab_;
+    AsyncQueue<Envelope> queue_;
+
+public:
+    explicit RequestQueue(size_t capacity = std::numeric_limits<size_t>::max())
+        : queue_(capacity) {}
+
+    RequestQueue(const RequestQueue&) = delete;
+    RequestQueue& operator=(const RequestQueue&) = delete;
+
+    // Enqueue a request, waiting for room. The returned PendingReply is
+    // invalid if the queue is closed.
+    PendingReply call(Req request) {
+        uint32_t generation = 0;
+        uint32_t index = slab_.acquire(generation);
+        if (!queue_.push(Envelope{std::move(request), Responder(&slab_, index, generation)})) {
+            // The rejected Envelope's Responder has already detached.
+            slab_.abandon(index, generation);
+            return PendingReply();
+        }
+        return PendingReply(&slab_, index, generation);
+    }
+
+    std::optional<Envelope> pop() {
+        return queue_.pop();
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<Envelope> try_pop(const std::chrono::duration<Rep, Period>& timeout) {
+        return queue_.try_pop(timeout);
+    }
+
+    void close() {
+        queue_.close();
+    }
+
+    bool is_closed() const {
+        return queue_.is_closed();
+    }
+
+    size_t size() const {
+        return queue_.size();
+    }
+
+    // Reply slots currently attached to a caller or responder.
+    size_t slots_in_use() const {
+        return slab_.in_use();
+    }
+};
+
+} // namespace async_queue
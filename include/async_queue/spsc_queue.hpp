@@ -0,0 +1,280 @@
+#pragma once
+#include "async_queue/futex.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace async_queue {
+
+// Option tags, kept out of the main namespace; queue_builder.hpp adds the
+// rest.
+namespace opt {
+
+// How an SpscQueue side waits for its peer.
+struct park {};            // sleep on a futex straight away
+struct spin_then_park {};  // poll briefly first, for peers that keep up
+
+} // namespace opt
+
+namespace detail {
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // namespace detail
+
+// Bounded queue for exactly one producer thread and one consumer thread,
+// with the same push/pop/close interface as AsyncQueue.
+//
+// Items live in a fixed ring allocated up front. Each side owns its index
+// and keeps a cached copy of the other's, so a push or pop touches shared
+// cache lines only when the cached view says the ring looks full or empty.
+// There is no mutex: a side that must wait parks on a futex word (after
+// spinning, with spin_then_park), and its peer makes the wake syscall only
+// when it sees that side parked. close() may be called from any thread;
+// items pushed before it can still be popped.
+template<typename T, typename Wait = opt::park>
+class SpscQueue {
+    static_assert(std::is_same_v<Wait, opt::park> || std::is_same_v<Wait, opt::spin_then_park>,
+                  "Wait must be opt::park or opt::spin_then_park");
+
+public:
+    using value_type = T;
+
+protected:
+    using Clock = std::chrono::steady_clock;
+
+    struct Slot {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    static constexpr int spins_ = std::is_same_v<Wait, opt::spin_then_park> ? 256 : 0;
+
+    static size_t ring_size(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    // Consumer's line.
+    alignas(64) std::atomic<size_t> head_{0};  // next slot to pop
+    size_t tail_cache_ = 0;
+    std::atomic<bool> consumer_parked_{false};
+    std::atomic<uint32_t> pushes_{0};  // futex word the consumer parks on
+
+    // Producer's line.
+    alignas(64) std::atomic<size_t> tail_{0};  // next slot to fill
+    size_t head_cache_ = 0;
+    std::atomic<bool> producer_parked_{false};
+    std::atomic<uint32_t> pops_{0};  // futex word the producer parks on
+
+    alignas(64) std::atomic<bool> closed_{false};
+
+    void* storage(size_t index) {
+        return slots_[index & mask_].bytes;
+    }
+
+    T* slot(size_t index) {
+        return std::launder(static_cast<T*>(storage(index)));
+    }
+
+    // Park on word until it moves past epoch or the deadline passes.
+    // Returns false on timeout.
+    static bool sleep(std::atomic<uint32_t>& word, uint32_t epoch,
+                      const Clock::time_point* deadline) {
+        if (!deadline) {
+            detail::futex_wait(&word, epoch);
+            return true;
+        }
+        auto left = *deadline - Clock::now();
+        if (left <= Clock::duration::zero()) {
+            return false;
+        }
+        auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(left);
+        detail::futex_wait(&word, epoch, &timeout);
+        return true;
+    }
+
+    static void wake(std::atomic<bool>& parked, std::atomic<uint32_t>& word) {
+        // Pairs with the fence in the waiter between setting parked and
+        // re-checking the index.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked.load(std::memory_order_relaxed)) {
+            word.fetch_add(1, std::memory_order_release);
+            detail::futex_wake_all(&word);
+        }
+    }
+
+    // Producer: wait for a free slot. False if closed or out of time.
+    bool wait_for_room(size_t tail, const Clock::time_point* deadline) {
+        for (int spin = 0;; ++spin) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (tail - head_cache_ < capacity_) {
+                return true;
+            }
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ < capacity_) {
+                return true;
+            }
+            if (spin < spins_) {
+                detail::cpu_relax();
+                continue;
+            }
+            uint32_t epoch = pops_.load(std::memory_order_acquire);
+            producer_parked_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool ready = tail - head_.load(std::memory_order_acquire) < capacity_ ||
+                         closed_.load(std::memory_order_acquire);
+            bool in_time = ready || sleep(pops_, epoch, deadline);
+            producer_parked_.store(false, std::memory_order_relaxed);
+            if (!in_time) {
+                return false;
+            }
+        }
+    }
+
+    // Consumer: wait for an item. False once closed and drained, or out of
+    // time.
+    bool wait_for_item(size_t head, const Clock::time_point* deadline) {
+        for (int spin = 0;; ++spin) {
+            if (head != tail_cache_) {
+                return true;
+            }
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head != tail_cache_) {
+                return true;
+            }
+            if (closed_.load(std::memory_order_acquire)) {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                return head != tail_cache_;
+            }
+            if (spin < spins_) {
+                detail::cpu_relax();
+                continue;
+            }
+            uint32_t epoch = pushes_.load(std::memory_order_acquire);
+            consumer_parked_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool ready = head != tail_.load(std::memory_order_acquire) ||
+                         closed_.load(std::memory_order_acquire);
+            bool in_time = ready || sleep(pushes_, epoch, deadline);
+            consumer_parked_.store(false, std::memory_order_relaxed);
+            if (!in_time) {
+                return false;
+            }
+        }
+    }
+
+    template<typename U>
+    bool push_until(U&& item, const Clock::time_point* deadline) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (!wait_for_room(tail, deadline)) {
+            return false;
+        }
+        ::new (storage(tail)) T(std::forward<U>(item));
+        tail_.store(tail + 1, std::memory_order_release);
+        wake(consumer_parked_, pushes_);
+        return true;
+    }
+
+    std::optional<T> pop_until(const Clock::time_point* deadline) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (!wait_for_item(head, deadline)) {
+            return std::nullopt;
+        }
+        T* stored = slot(head);
+        std::optional<T> item(std::move(*stored));
+        stored->~T();
+        head_.store(head + 1, std::memory_order_release);
+        wake(producer_parked_, pops_);
+        return item;
+    }
+
+public:
+    explicit SpscQueue(size_t capacity = 1024)
+        : capacity_(capacity > 0 ? capacity : 1),
+          mask_(ring_size(capacity_) - 1),
+          slots_(new Slot[mask_ + 1]) {}
+
+    ~SpscQueue() {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        for (size_t head = head_.load(std::memory_order_relaxed); head != tail; ++head) {
+            slot(head)->~T();
+        }
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer thread only. Returns false if the queue is closed.
+    template<typename U>
+    bool push(U&& item) {
+        return push_until(std::forward<U>(item), nullptr);
+    }
+
+    // The item is only moved from if it was queued.
+    template<typename U, typename Rep, typename Period>
+    bool try_push(U&& item, const std::chrono::duration<Rep, Period>& timeout) {
+        auto deadline = Clock::now() + timeout;
+        return push_until(std::forward<U>(item), &deadline);
+    }
+
+    // Consumer thread only. Returns nullopt once closed and drained.
+    std::optional<T> pop() {
+        return pop_until(nullptr);
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<T> try_pop(const std::chrono::duration<Rep, Period>& timeout) {
+        auto deadline = Clock::now() + timeout;
+        return pop_until(&deadline);
+    }
+
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        pushes_.fetch_add(1, std::memory_order_release);
+        pops_.fetch_add(1, std::memory_order_release);
+        detail::futex_wake_all(&pushes_);
+        detail::futex_wake_all(&pops_);
+    }
+
+    bool is_closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    // Approximate while both sides are running.
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+};
+
+} // namespace async_queue
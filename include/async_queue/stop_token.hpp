@@ -0,0 +1,141 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace async_queue {
+
+// Minimal C++17 stand-in for std::stop_source / stop_token / stop_callback,
+// used to cancel the asynchronous operations in async.hpp. A StopSource
+// allocates its shared state once; registering a StopCallback links a node
+// that lives inside the callback object and never allocates.
+
+namespace detail {
+
+struct StopCallbackNode {
+    void (*invoke)(StopCallbackNode*) = nullptr;
+    StopCallbackNode* prev = nullptr;
+    StopCallbackNode* next = nullptr;
+    bool linked = false;
+};
+
+struct StopState {
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool stopped = false;
+    WaiterList<StopCallbackNode> callbacks;
+    StopCallbackNode* running = nullptr;  // callback being invoked, if any
+    std::thread::id runner;                // thread that requested the stop
+};
+
+} // namespace detail
+
+class StopToken {
+    std::shared_ptr<detail::StopState> state_;
+
+    template<typename F>
+    friend class StopCallback;
+    friend class StopSource;
+
+    explicit StopToken(std::shared_ptr<detail::StopState> state) : state_(std::move(state)) {}
+
+public:
+    // A token that is never stopped.
+    StopToken() = default;
+
+    bool stop_requested() const {
+        if (!state_) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->stopped;
+    }
+
+    bool stop_possible() const {
+        return state_ != nullptr;
+    }
+};
+
+class StopSource {
+    std::shared_ptr<detail::StopState> state_ = std::make_shared<detail::StopState>();
+
+public:
+    StopToken get_token() const {
+        return StopToken(state_);
+    }
+
+    bool stop_requested() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->stopped;
+    }
+
+    // Run every registered callback on this thread. Returns false if a
+    // stop was already requested.
+    bool request_stop() {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        if (state_->stopped) {
+            return false;
+        }
+        state_->stopped = true;
+        state_->runner = std::this_thread::get_id();
+        while (detail::StopCallbackNode* node = state_->callbacks.pop_front()) {
+            state_->running = node;
+            lock.unlock();
+            node->invoke(node);
+            lock.lock();
+            state_->running = nullptr;
+            state_->finished.notify_all();
+        }
+        return true;
+    }
+};
+
+// Calls f once a stop is requested on token, or right away if one already
+// was. The destructor unregisters f; if f is running on another thread at
+// that moment, it waits for f to return.
+template<typename F>
+class StopCallback : detail::StopCallbackNode {
+    std::shared_ptr<detail::StopState> state_;
+    F f_;
+
+    static void run(detail::StopCallbackNode* node) {
+        static_cast<StopCallback*>(node)->f_();
+    }
+
+public:
+    StopCallback(const StopToken& token, F f) : state_(token.state_), f_(std::move(f)) {
+        invoke = &StopCallback::run;
+        if (!state_) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        if (!state_->stopped) {
+            state_->callbacks.push_back(this);
+            return;
+        }
+        lock.unlock();
+        f_();
+    }
+
+    ~StopCallback() {
+        if (!state_) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        if (linked) {
+            state_->callbacks.erase(this);
+        } else if (state_->running == this && state_->runner != std::this_thread::get_id()) {
+            state_->finished.wait(lock, [this] {
+                return state_->running != this;
+            });
+        }
+    }
+
+    StopCallback(const StopCallback&) = delete;
+    StopCallback& operator=(const StopCallback&) = delete;
+};
+
+} // namespace async_queue
@@ -0,0 +1,473 @@
+#pragma once
+#include "async_queue/async_queue.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace async_queue {
+
+// Lazy stream operators fused into a queue's pop() or push() path, so a
+// filter or transform between two stages needs no extra thread or queue.
+//
+// Consumer side: `queue | filter(p) | map(f) | batch(n)` is a stream whose
+// pop()/try_pop() pull from the queue and apply each operator in the
+// calling thread. pop() returns nullopt once the queue is closed and
+// drained; batch(n) first hands out the partial last batch.
+//
+// Producer side: `pipe<In>() | filter(p) | map(f) | into(queue)` is a sink
+// whose push() applies the operators before the item enters the queue.
+// close() flushes a partial batch and closes the queue. A sink may be shared
+// by several producer threads as long as its functions are safe to call
+// concurrently; batch(n) serializes the producers while it fills a batch.
+
+namespace detail {
+
+struct StageTag {};
+
+template<typename S>
+inline constexpr bool is_stage = std::is_base_of_v<StageTag, std::decay_t<S>>;
+
+using Clock = std::chrono::steady_clock;
+
+inline Clock::duration remaining(Clock::time_point deadline) {
+    auto left = deadline - Clock::now();
+    return left > Clock::duration::zero() ? left : Clock::duration::zero();
+}
+
+// The queue at the head of a consumer-side chain.
+template<typename T>
+class QueueSource {
+    AsyncQueue<T>* queue_;
+
+public:
+    using value_type = T;
+
+    explicit QueueSource(AsyncQueue<T>& queue) : queue_(&queue) {}
+
+    std::optional<T> pop() {
+        return queue_->pop();
+    }
+
+    std::optional<T> pop_until(Clock::time_point deadline) {
+        return queue_->try_pop(remaining(deadline));
+    }
+
+    void close() {
+        queue_->close();
+    }
+};
+
+// The queue at the end of a producer-side chain.
+template<typename T>
+class QueueSink {
+    AsyncQueue<T>* queue_;
+
+public:
+    explicit QueueSink(AsyncQueue<T>& queue) : queue_(&queue) {}
+
+    template<typename U>
+    bool push(U&& item) {
+        return queue_->push(std::forward<U>(item));
+    }
+
+    void close() {
+        queue_->close();
+    }
+};
+
+template<typename Source, typename Pred>
+class FilterStream {
+    Source source_;
+    Pred pred_;
+
+public:
+    using value_type = typename Source::value_type;
+
+    FilterStream(Source source, Pred pred)
+        : source_(std::move(source)), pred_(std::move(pred)) {}
+
+    std::optional<value_type> pop() {
+        while (auto item = source_.pop()) {
+            if (pred_(static_cast<const value_type&>(*item))) {
+                return item;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<value_type> pop_until(Clock::time_point deadline) {
+        while (auto item = source_.pop_until(deadline)) {
+            if (pred_(static_cast<const value_type&>(*item))) {
+                return item;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void close() {
+        source_.close();
+    }
+};
+
+template<typename Source, typename F>
+class MapStream {
+    Source source_;
+    F f_;
+
+public:
+    using value_type = std::decay_t<std::invoke_result_t<F&, typename Source::value_type&&>>;
+
+    MapStream(Source source, F f) : source_(std::move(source)), f_(std::move(f)) {}
+
+    std::optional<value_type> pop() {
+        if (auto item = source_.pop()) {
+            return f_(std::move(*item));
+        }
+        return std::nullopt;
+    }
+
+    std::optional<value_type> pop_until(Clock::time_point deadline) {
+        if (auto item = source_.pop_until(deadline)) {
+            return f_(std::move(*item));
+        }
+        return std::nullopt;
+    }
+
+    void close() {
+        source_.close();
+    }
+};
+
+template<typename Source>
+class BatchStream {
+    Source source_;
+    size_t size_;
+
+public:
+    using value_type = std::vector<typename Source::value_type>;
+
+    BatchStream(Source source, size_t size)
+        : source_(std::move(source)), size_(size > 0 ? size : 1) {}
+
+    // A full batch, or the partial last one once the source is closed.
+    std::optional<value_type> pop() {
+        value_type batch;
+        batch.reserve(size_);
+        while (batch.size() < size_) {
+            auto item = source_.pop();
+            if (!item) {
+                break;
+            }
+            batch.push_back(std::move(*item));
+        }
+        if (batch.empty()) {
+            return std::nullopt;
+        }
+        return batch;
+    }
+
+    // Whatever arrived by the deadline, up to a full batch.
+    std::optional<value_type> pop_until(Clock::time_point deadline) {
+        value_type batch;
+        batch.reserve(size_);
+        while (batch.size() < size_) {
+            auto item = source_.pop_until(deadline);
+            if (!item) {
+                break;
+            }
+            batch.push_back(std::move(*item));
+        }
+        if (batch.empty()) {
+            return std::nullopt;
+        }
+        return batch;
+    }
+
+    void close() {
+        source_.close();
+    }
+};
+
+template<typename Sink, typename Pred>
+class FilterSink {
+    Sink next_;
+    Pred pred_;
+
+public:
+    FilterSink(Sink next, Pred pred) : next_(std::move(next)), pred_(std::move(pred)) {}
+
+    // Filtered-out items count as accepted.
+    template<typename U>
+    bool push(U&& item) {
+        if (!pred_(static_cast<const std::decay_t<U>&>(item))) {
+            return true;
+        }
+        return next_.push(std::forward<U>(item));
+    }
+
+    void close() {
+        next_.close();
+    }
+};
+
+template<typename Sink, typename F>
+class MapSink {
+    Sink next_;
+    F f_;
+
+public:
+    MapSink(Sink next, F f) : next_(std::move(next)), f_(std::move(f)) {}
+
+    template<typename U>
+    bool push(U&& item) {
+        return next_.push(f_(std::forward<U>(item)));
+    }
+
+    void close() {
+        next_.close();
+    }
+};
+
+template<typename Sink, typename T>
+class BatchSink {
+    Sink next_;
+    size_t size_;
+    // On the heap so the sink stays movable while the chain is built.
+    std::unique_ptr<std::mutex> mutex_ = std::make_unique<std::mutex>();
+    std::vector<T> batch_;
+    bool closed_ = false;
+
+    // mutex_ must be held. Pushing under it keeps batches in order and
+    // lets close() flush last.
+    bool flush() {
+        if (batch_.empty()) {
+            return true;
+        }
+        std::vector<T> full;
+        full.reserve(size_);
+        std::swap(full, batch_);
+        return next_.push(std::move(full));
+    }
+
+public:
+    BatchSink(Sink next, size_t size) : next_(std::move(next)), size_(size > 0 ? size : 1) {
+        batch_.reserve(size_);
+    }
+
+    // Items are held until the batch is full; false after close() or if the
+    // batch they completed could not be pushed.
+    template<typename U>
+    bool push(U&& item) {
+        std::lock_guard<std::mutex> lock(*mutex_);
+        if (closed_) {
+            return false;
+        }
+        batch_.push_back(std::forward<U>(item));
+        return batch_.size() < size_ || flush();
+    }
+
+    // Push the partial batch, then close downstream.
+    void close() {
+        std::lock_guard<std::mutex> lock(*mutex_);
+        flush();
+        closed_ = true;
+        next_.close();
+    }
+};
+
+} // namespace detail
+
+template<typename Pred>
+struct FilterStage : detail::StageTag {
+    Pred pred;
+
+    template<typename In>
+    using output = In;
+
+    template<typename Source>
+    auto pull(Source source) && {
+        return detail::FilterStream<Source, Pred>(std::move(source), std::move(pred));
+    }
+
+    template<typename In, typename Sink>
+    auto push_into(Sink next) && {
+        return detail::FilterSink<Sink, Pred>(std::move(next), std::move(pred));
+    }
+};
+
+template<typename F>
+struct MapStage : detail::StageTag {
+    F f;
+
+    template<typename In>
+    using output = std::decay_t<std::invoke_result_t<F&, In&&>>;
+
+    template<typename Source>
+    auto pull(Source source) && {
+        return detail::MapStream<Source, F>(std::move(source), std::move(f));
+    }
+
+    template<typename In, typename Sink>
+    auto push_into(Sink next) && {
+        return detail::MapSink<Sink, F>(std::move(next), std::move(f));
+    }
+};
+
+struct BatchStage : detail::StageTag {
+    size_t size;
+
+    template<typename In>
+    using output = std::vector<In>;
+
+    template<typename Source>
+    auto pull(Source source) && {
+        return detail::BatchStream<Source>(std::move(source), size);
+    }
+
+    template<typename In, typename Sink>
+    auto push_into(Sink next) && {
+        return detail::BatchSink<Sink, In>(std::move(next), size);
+    }
+};
+
+// Keep items for which pred returns true.
+template<typename Pred>
+FilterStage<Pred> filter(Pred pred) {
+    return FilterStage<Pred>{{}, std::move(pred)};
+}
+
+// Replace each item with f(item).
+template<typename F>
+MapStage<F> map(F f) {
+    return MapStage<F>{{}, std::move(f)};
+}
+
+// Group items into std::vectors of size n.
+inline BatchStage batch(size_t n) {
+    return BatchStage{{}, n};
+}
+
+// End of a producer-side chain.
+template<typename T>
+struct Into {
+    AsyncQueue<T>* queue;
+};
+
+template<typename T>
+Into<T> into(AsyncQueue<T>& queue) {
+    return Into<T>{&queue};
+}
+
+// A consumer-side chain with the usual pop()/try_pop() interface.
+template<typename Chain>
+class Stream {
+    Chain chain_;
+
+public:
+    using value_type = typename Chain::value_type;
+
+    explicit Stream(Chain chain) : chain_(std::move(chain)) {}
+
+    // Next value, or nullopt once the source queue is closed and drained.
+    std::optional<value_type> pop() {
+        return chain_.pop();
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<value_type> try_pop(const std::chrono::duration<Rep, Period>& timeout) {
+        return chain_.pop_until(detail::Clock::now() + timeout);
+    }
+
+    // Close the source queue.
+    void close() {
+        chain_.close();
+    }
+
+    template<typename Stage, typename = std::enable_if_t<detail::is_stage<Stage>>>
+    friend auto operator|(Stream stream, Stage stage) {
+        return Stream<decltype(std::move(stage).pull(std::move(stream.chain_)))>(
+            std::move(stage).pull(std::move(stream.chain_)));
+    }
+};
+
+// A producer-side chain: push() runs the operators and feeds the queue.
+template<typename Chain>
+class Sink {
+    Chain chain_;
+
+public:
+    explicit Sink(Chain chain) : chain_(std::move(chain)) {}
+
+    // False if the queue rejected the item (it is closed).
+    template<typename U>
+    bool push(U&& item) {
+        return chain_.push(std::forward<U>(item));
+    }
+
+    // Flush any partial batch and close the queue.
+    void close() {
+        chain_.close();
+    }
+};
+
+template<typename T, typename Stage, typename = std::enable_if_t<detail::is_stage<Stage>>>
+auto operator|(AsyncQueue<T>& queue, Stage stage) {
+    return Stream<detail::QueueSource<T>>(detail::QueueSource<T>(queue)) | std::move(stage);
+}
+
+namespace detail {
+
+// Wrap the queue in the stages from last to first. In is the item type
+// entering the first stage.
+template<typename In, typename T>
+auto build_sink(std::tuple<>, Into<T> into) {
+    static_assert(std::is_constructible_v<T, In&&>,
+                  "the last stage's output does not fit the queue");
+    return QueueSink<T>(*into.queue);
+}
+
+template<typename In, typename T, typename First, typename... Rest>
+auto build_sink(std::tuple<First, Rest...> stages, Into<T> into) {
+    using Out = typename First::template output<In>;
+    auto rest = std::apply([](auto&&, auto&&... r) {
+        return std::make_tuple(std::move(r)...);
+    }, std::move(stages));
+    return std::move(std::get<0>(stages)).template push_into<In>(
+        build_sink<Out>(std::move(rest), into));
+}
+
+} // namespace detail
+
+// Start of a producer-side chain taking items of type In:
+// `pipe<In>() | filter(p) | map(f) | into(queue)`.
+template<typename In, typename... Stages>
+class SinkBuilder {
+    std::tuple<Stages...> stages_;
+
+public:
+    explicit SinkBuilder(std::tuple<Stages...> stages = {}) : stages_(std::move(stages)) {}
+
+    template<typename Stage, typename = std::enable_if_t<detail::is_stage<Stage>>>
+    friend auto operator|(SinkBuilder builder, Stage stage) {
+        return SinkBuilder<In, Stages..., Stage>(
+            std::tuple_cat(std::move(builder.stages_), std::make_tuple(std::move(stage))));
+    }
+
+    template<typename T>
+    friend auto operator|(SinkBuilder builder, Into<T> into) {
+        auto chain = detail::build_sink<In>(std::move(builder.stages_), into);
+        return Sink<decltype(chain)>(std::move(chain));
+    }
+};
+
+template<typename In>
+SinkBuilder<In> pipe() {
+    return SinkBuilder<In>();
+}
+
+} // namespace async_queue
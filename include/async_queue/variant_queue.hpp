@@ -0,0 +1,377 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace async_queue {
+
+namespace detail {
+
+// Fixed ring of equal-size raw slots. Storage is allocated on first use,
+// so size classes no message ever needs cost nothing. Writing is two-phase:
+// prepare() returns the next free slot, the owner constructs the object in
+// it, and commit() stores it. If construction throws, nothing was committed
+// and the ring is unchanged. Not thread-safe; the owner constructs and
+// destroys the objects in the slots.
+class SlotRing {
+    std::unique_ptr<std::max_align_t[]> buffer_;
+    size_t slot_size_ = 0;
+    size_t slots_ = 0;
+    size_t head_ = 0;
+    size_t count_ = 0;
+
+    void* slot(size_t index) const {
+        return reinterpret_cast<unsigned char*>(buffer_.get()) + index * slot_size_;
+    }
+
+public:
+    void init(size_t slot_size, size_t slots) {
+        slot_size_ = slot_size;
+        slots_ = slots;
+    }
+
+    // Requires fewer than slots() objects stored.
+    void* prepare() {
+        if (!buffer_) {
+            size_t words = (slot_size_ * slots_ + sizeof(std::max_align_t) - 1) /
+                           sizeof(std::max_align_t);
+            buffer_.reset(new std::max_align_t[words]);
+        }
+        size_t index = head_ + count_;
+        if (index >= slots_) {
+            index -= slots_;
+        }
+        return slot(index);
+    }
+
+    // The slot from the last prepare() now holds an object.
+    void commit() {
+        ++count_;
+    }
+
+    void* front() const {
+        return slot(head_);
+    }
+
+    void pop() {
+        if (++head_ == slots_) {
+            head_ = 0;
+        }
+        --count_;
+    }
+
+    size_t slot_size() const {
+        return slot_size_;
+    }
+};
+
+inline constexpr size_t size_class(size_t size, size_t align) {
+    size_t bytes = size > align ? size : align;
+    size_t slot = 8;
+    while (slot < bytes) {
+        slot *= 2;
+    }
+    return slot;
+}
+
+} // namespace detail
+
+template<typename Variant>
+class VariantQueue;
+
+// FIFO queue for a closed set of message types, stored as std::variant
+// alternatives without paying for the largest alternative on every slot.
+//
+// Alternatives are grouped into power-of-two size classes, and each class
+// has its own ring of slots that size, so a small alternative only moves a
+// small slot through the cache. A separate one-byte-per-message ring of
+// alternative indices keeps FIFO order across classes. Capacity counts
+// messages; every ring is sized for it up front and nothing is allocated
+// per message.
+//
+// pop() rebuilds the variant. pop_visit(f) skips the variant entirely: the
+// alternative is moved out of its slot and f is called with it directly.
+template<typename... Ts>
+class VariantQueue<std::variant<Ts...>> {
+public:
+    using value_type = std::variant<Ts...>;
+
+    static_assert(sizeof...(Ts) < 256, "alternative index must fit in a byte");
+    static_assert(((alignof(Ts) <= alignof(std::max_align_t)) && ...),
+                  "over-aligned alternatives are not supported");
+
+    static constexpr size_t alternatives = sizeof...(Ts);
+
+    // Slot size used for alternative I.
+    template<size_t I>
+    static constexpr size_t slot_size =
+        detail::size_class(sizeof(std::variant_alternative_t<I, value_type>),
+                           alignof(std::variant_alternative_t<I, value_type>));
+
+protected:
+    static constexpr size_t slot_sizes_[] = {detail::size_class(sizeof(Ts), alignof(Ts))...};
+
+    // Alternatives of the same size class share the first one's ring.
+    static constexpr size_t class_of(size_t index) {
+        for (size_t i = 0; i < index; ++i) {
+            if (slot_sizes_[i] == slot_sizes_[index]) {
+                return i;
+            }
+        }
+        return index;
+    }
+
+    template<typename U>
+    static constexpr size_t index_of() {
+        constexpr bool matches[] = {std::is_same_v<U, Ts>...};
+        for (size_t i = 0; i < sizeof...(Ts); ++i) {
+            if (matches[i]) {
+                return i;
+            }
+        }
+        return sizeof...(Ts);
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    detail::SlotRing rings_[sizeof...(Ts)];
+    std::unique_ptr<uint8_t[]> order_;  // alternative index per message
+    size_t order_head_ = 0;
+    size_t size_ = 0;
+    bool closed_ = false;
+    const size_t capacity_;
+
+    template<size_t I>
+    using Alt = std::variant_alternative_t<I, value_type>;
+
+    template<size_t I, typename U>
+    void store(U&& item) {
+        detail::SlotRing& ring = rings_[class_of(I)];
+        ::new (ring.prepare()) Alt<I>(std::forward<U>(item));
+        ring.commit();
+        size_t tail = order_head_ + size_;
+        order_[tail >= capacity_ ? tail - capacity_ : tail] = static_cast<uint8_t>(I);
+        ++size_;
+        not_empty_.notify_one();
+    }
+
+    template<typename U>
+    void store_any(U&& item) {
+        using D = std::decay_t<U>;
+        if constexpr (std::is_same_v<D, value_type>) {
+            dispatch(item.index(), [&](auto index) {
+                constexpr size_t I = decltype(index)::value;
+                store<I>(std::get<I>(std::forward<U>(item)));
+            });
+        } else {
+            store<index_of<D>()>(std::forward<U>(item));
+        }
+    }
+
+    template<size_t I>
+    Alt<I> take() {
+        detail::SlotRing& ring = rings_[class_of(I)];
+        Alt<I>* stored = std::launder(static_cast<Alt<I>*>(ring.front()));
+        Alt<I> item(std::move(*stored));
+        stored->~Alt<I>();
+        ring.pop();
+        if (++order_head_ == capacity_) {
+            order_head_ = 0;
+        }
+        --size_;
+        not_full_.notify_one();
+        return item;
+    }
+
+    // Call f(std::integral_constant<size_t, I>) for I == index.
+    template<typename F>
+    static void dispatch(size_t index, F&& f) {
+        dispatch(index, f, std::index_sequence_for<Ts...>{});
+    }
+
+    template<typename F, size_t... I>
+    static void dispatch(size_t index, F& f, std::index_sequence<I...>) {
+        ((index == I ? (f(std::integral_constant<size_t, I>{}), true) : false) || ...);
+    }
+
+    template<typename U>
+    static constexpr bool accepts =
+        std::is_same_v<std::decay_t<U>, value_type> ||
+        index_of<std::decay_t<U>>() < sizeof...(Ts);
+
+    template<typename U>
+    static bool storable(const U& item) {
+        if constexpr (std::is_same_v<std::decay_t<U>, value_type>) {
+            return !item.valueless_by_exception();
+        } else {
+            return true;
+        }
+    }
+
+    template<typename F>
+    bool visit_front(std::unique_lock<std::mutex>& lock, F& f) {
+        if (size_ == 0) {
+            return false;
+        }
+        dispatch(order_[order_head_], [&](auto index) {
+            auto item = take<decltype(index)::value>();
+            lock.unlock();
+            f(item);
+        });
+        return true;
+    }
+
+    std::optional<value_type> take_front() {
+        std::optional<value_type> result;
+        dispatch(order_[order_head_], [&](auto index) {
+            constexpr size_t I = decltype(index)::value;
+            result.emplace(std::in_place_index<I>, take<I>());
+        });
+        return result;
+    }
+
+public:
+    explicit VariantQueue(size_t capacity = 1024)
+        : order_(new uint8_t[capacity > 0 ? capacity : 1]),
+          capacity_(capacity > 0 ? capacity : 1) {
+        for (size_t i = 0; i < sizeof...(Ts); ++i) {
+            rings_[i].init(slot_sizes_[i], capacity_);
+        }
+    }
+
+    ~VariantQueue() {
+        while (size_ > 0) {
+            take_front();
+        }
+    }
+
+    VariantQueue(const VariantQueue&) = delete;
+    VariantQueue& operator=(const VariantQueue&) = delete;
+
+    // Push a variant or one of its alternatives. Returns false if the
+    // queue is closed (or the variant is valueless).
+    template<typename U, typename = std::enable_if_t<accepts<U>>>
+    bool push(U&& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        not_full_.wait(lock, [this] {
+            return size_ < capacity_ || closed_;
+        });
+
+        if (closed_ || !storable(item)) {
+            return false;
+        }
+
+        store_any(std::forward<U>(item));
+        return true;
+    }
+
+    // Like push, but gives up after timeout. The item is only moved from
+    // if it was queued.
+    template<typename U, typename Rep, typename Period,
+             typename = std::enable_if_t<accepts<U>>>
+    bool try_push(U&& item, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!not_full_.wait_for(lock, timeout, [this] {
+            return size_ < capacity_ || closed_;
+        })) {
+            return false;
+        }
+
+        if (closed_ || !storable(item)) {
+            return false;
+        }
+
+        store_any(std::forward<U>(item));
+        return true;
+    }
+
+    std::optional<value_type> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        not_empty_.wait(lock, [this] {
+            return size_ > 0 || closed_;
+        });
+
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+        return take_front();
+    }
+
+    template<typename Rep, typename Period>
+    std::optional<value_type> try_pop(const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        not_empty_.wait_for(lock, timeout, [this] {
+            return size_ > 0 || closed_;
+        });
+
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+        return take_front();
+    }
+
+    // Wait for a message and call f with its alternative, outside the lock.
+    // Returns false once the queue is closed and empty.
+    template<typename F>
+    bool pop_visit(F&& f) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        not_empty_.wait(lock, [this] {
+            return size_ > 0 || closed_;
+        });
+
+        return visit_front(lock, f);
+    }
+
+    template<typename F, typename Rep, typename Period>
+    bool try_pop_visit(F&& f, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        not_empty_.wait_for(lock, timeout, [this] {
+            return size_ > 0 || closed_;
+        });
+
+        return visit_front(lock, f);
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    bool is_closed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_ == 0;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+};
+
+} // namespace async_queue
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "async_queue/async_queue.hpp"
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(AdaptiveLifoTest, FifoWhileDelayIsLow) {
+    AsyncQueue<int> queue;
+    queue.set_adaptive_lifo(1s);
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    EXPECT_EQ(*queue.pop(), 1);
+    EXPECT_EQ(*queue.pop(), 2);
+    EXPECT_FALSE(queue.lifo_stats().lifo);
+}
+
+TEST(AdaptiveLifoTest, SwitchesToLifoUnderBacklogAndBack) {
+    AsyncQueue<int> queue;
+    queue.set_adaptive_lifo(5ms);
+    queue.push(1);
+    queue.push(2);
+    std::this_thread::sleep_for(10ms);
+    queue.push(3);
+    queue.push(4);
+
+    EXPECT_EQ(*queue.pop(), 4);  // Oldest waited too long: newest first
+    EXPECT_TRUE(queue.lifo_stats().lifo);
+    EXPECT_EQ(*queue.pop(), 3);
+    EXPECT_EQ(*queue.pop(), 2);
+    EXPECT_EQ(*queue.pop(), 1);  // Backlog cleared
+
+    queue.push(5);
+    queue.push(6);
+    EXPECT_EQ(*queue.pop(), 5);
+    auto stats = queue.lifo_stats();
+    EXPECT_FALSE(stats.lifo);
+    EXPECT_EQ(stats.switches, 2u);
+    EXPECT_GT(stats.fifo_time, 5ms);
+}
+
+TEST(AdaptiveLifoTest, SkipsCancelledItemsAtBack) {
+    AsyncQueue<int> queue;
+    queue.set_adaptive_lifo(1ms);
+    queue.push(1);
+    queue.push(2);
+    auto h = queue.push_tracked(3);
+    ASSERT_TRUE(h);
+    queue.cancel(*h);
+    std::this_thread::sleep_for(5ms);
+
+    EXPECT_EQ(*queue.pop(), 2);
+    EXPECT_EQ(*queue.pop(), 1);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(AdaptiveLifoTest, ModeTimeIsAccounted) {
+    AsyncQueue<int> queue;
+    queue.set_adaptive_lifo(1ms);
+    for (int i = 0; i < 3; ++i) {
+        queue.push(i);
+    }
+    std::this_thread::sleep_for(5ms);
+    queue.pop();  // Enters LIFO
+    std::this_thread::sleep_for(20ms);
+    auto stats = queue.lifo_stats();
+    EXPECT_TRUE(stats.lifo);
+    EXPECT_GE(stats.lifo_time, 15ms);
+
+    queue.disable_adaptive_lifo();
+    EXPECT_FALSE(queue.lifo_stats().lifo);
+    EXPECT_EQ(*queue.pop(), 0);  // Plain FIFO again
+}
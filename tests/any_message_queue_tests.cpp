@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "async_queue/any_message_queue.hpp"
+#include <array>
+#include <memory>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Tick {
+    int n;
+};
+
+struct Big {
+    std::array<char, 200> payload;
+    int id;
+};
+
+struct Counted {
+    static int live;
+    Counted() { ++live; }
+    Counted(Counted&&) noexcept { ++live; }
+    ~Counted() { --live; }
+};
+int Counted::live = 0;
+
+} // namespace
+
+static_assert(AnyMessageQueue<64>::stores_inline<Tick>);
+static_assert(AnyMessageQueue<64>::stores_inline<std::unique_ptr<int>>);
+static_assert(!AnyMessageQueue<64>::stores_inline<Big>);
+
+TEST(AnyMessageQueueTest, MixedTypesInOrder) {
+    AnyMessageQueue<> queue;
+    queue.push(Tick{1});
+    queue.push(std::string("hello"));
+    queue.push(std::make_unique<int>(7));
+    Big big{};
+    big.id = 42;
+    queue.push(big);
+    EXPECT_EQ(queue.size(), 4);
+
+    std::vector<std::string> seen;
+    auto visitor = [&](const MessageRef& msg) {
+        bool known = visit<Tick, std::string, std::unique_ptr<int>, Big>(msg, [&](auto& m) {
+            using M = std::decay_t<decltype(m)>;
+            if constexpr (std::is_same_v<M, Tick>) {
+                seen.push_back("tick " + std::to_string(m.n));
+            } else if constexpr (std::is_same_v<M, std::string>) {
+                seen.push_back(m);
+            } else if constexpr (std::is_same_v<M, Big>) {
+                seen.push_back("big " + std::to_string(m.id));
+            } else {
+                seen.push_back("ptr " + std::to_string(*m));
+            }
+        });
+        EXPECT_TRUE(known);
+    };
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.pop(visitor));
+    }
+    EXPECT_EQ(seen, (std::vector<std::string>{"tick 1", "hello", "ptr 7", "big 42"}));
+    EXPECT_EQ(queue.bytes_used(), 0);
+}
+
+TEST(AnyMessageQueueTest, MoveOnlyMessageCanBeTaken) {
+    AnyMessageQueue<> queue;
+    queue.push(std::make_unique<int>(5));
+
+    std::unique_ptr<int> taken;
+    queue.pop([&](const MessageRef& msg) {
+        ASSERT_TRUE(msg.is<std::unique_ptr<int>>());
+        EXPECT_FALSE(msg.is<int>());
+        taken = std::move(msg.get<std::unique_ptr<int>>());
+    });
+    ASSERT_TRUE(taken);
+    EXPECT_EQ(*taken, 5);
+}
+
+TEST(AnyMessageQueueTest, FullRingBlocksAndTryPushLeavesMessage) {
+    AnyMessageQueue<16> queue(64);  // Two 32-byte records
+    queue.push(Tick{1});
+    queue.push(Tick{2});
+
+    auto text = std::make_unique<int>(3);
+    EXPECT_FALSE(queue.try_push(std::move(text), 20ms));
+    EXPECT_TRUE(text);  // Not moved from on failure
+
+    std::thread consumer([&]() {
+        std::this_thread::sleep_for(20ms);
+        queue.pop([](const MessageRef&) {});
+    });
+    EXPECT_TRUE(queue.push(std::move(text)));
+    consumer.join();
+    EXPECT_EQ(queue.size(), 2);
+}
+
+TEST(AnyMessageQueueTest, WrapsAroundUnderLoad) {
+    AnyMessageQueue<32> queue(256);
+    constexpr int count = 10000;
+
+    std::thread producer([&]() {
+        for (int i = 0; i < count; ++i) {
+            if (i % 3 == 0) {
+                queue.push(std::string(static_cast<size_t>(i % 17), 'x'));
+            } else {
+                queue.push(Tick{i});
+            }
+        }
+        queue.close();
+    });
+
+    int next = 0;
+    while (queue.pop([&](const MessageRef& msg) {
+        if (next % 3 == 0) {
+            ASSERT_TRUE(msg.is<std::string>());
+            EXPECT_EQ(msg.get<std::string>().size(), static_cast<size_t>(next % 17));
+        } else {
+            ASSERT_TRUE(msg.is<Tick>());
+            EXPECT_EQ(msg.get<Tick>().n, next);
+        }
+        ++next;
+    })) {
+    }
+    producer.join();
+    EXPECT_EQ(next, count);
+}
+
+TEST(AnyMessageQueueTest, PendingMessagesAreDestroyed) {
+    {
+        AnyMessageQueue<> queue;
+        queue.push(Counted{});
+        queue.push(Counted{});
+        EXPECT_EQ(Counted::live, 2);
+        queue.pop([](const MessageRef&) {});
+        EXPECT_EQ(Counted::live, 1);
+    }
+    EXPECT_EQ(Counted::live, 0);
+}
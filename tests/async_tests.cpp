@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include "async_queue/async.hpp"
+#include <memory>
+#include <optional>
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Records the completion; run on the test's own RunLoop.
+template<typename Value>
+struct TestReceiver {
+    RunLoop* loop;
+    std::optional<Value>* value;
+    bool* stopped;
+    StopToken token;
+
+    void set_value(Value v) { value->emplace(std::move(v)); }
+    void set_stopped() { *stopped = true; }
+    RunLoop::Scheduler get_scheduler() const { return loop->get_scheduler(); }
+    StopToken get_stop_token() const { return token; }
+};
+
+} // namespace
+
+TEST(AsyncTest, PopCompletesOnSchedulerAfterPush) {
+    AsyncQueue<int> queue;
+    RunLoop loop;
+    std::optional<std::optional<int>> value;
+    bool stopped = false;
+
+    auto op = connect(async_pop(queue),
+                      TestReceiver<std::optional<int>>{&loop, &value, &stopped, {}});
+    op.start();
+    EXPECT_EQ(loop.poll(), 0u);
+
+    queue.push(5);
+    EXPECT_FALSE(value.has_value());  // Not run inside push()
+    EXPECT_EQ(loop.poll(), 1u);
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, std::optional<int>(5));
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(AsyncTest, SyncWaitPopAndPush) {
+    AsyncQueue<std::unique_ptr<int>> queue(1);
+    EXPECT_EQ(sync_wait(async_push(queue, std::make_unique<int>(1))), std::optional<bool>(true));
+
+    std::thread consumer([&]() {
+        std::this_thread::sleep_for(20ms);
+        queue.pop();
+    });
+    // Full: parks until the consumer frees the slot.
+    EXPECT_EQ(sync_wait(async_push(queue, std::make_unique<int>(2))), std::optional<bool>(true));
+    consumer.join();
+
+    auto item = sync_wait(async_pop(queue));
+    ASSERT_TRUE(item && *item);
+    EXPECT_EQ(***item, 2);
+
+    queue.close();
+    EXPECT_EQ(sync_wait(async_push(queue, std::make_unique<int>(3))), std::optional<bool>(false));
+    auto end = sync_wait(async_pop(queue));
+    ASSERT_TRUE(end.has_value());
+    EXPECT_FALSE(end->has_value());
+}
+
+TEST(AsyncTest, StopTokenCancelsParkedPop) {
+    AsyncQueue<int> queue;
+    RunLoop loop;
+    StopSource source;
+    std::optional<std::optional<int>> value;
+    bool stopped = false;
+
+    auto op = connect(async_pop(queue), TestReceiver<std::optional<int>>{
+                                            &loop, &value, &stopped, source.get_token()});
+    op.start();
+    source.request_stop();
+    EXPECT_EQ(loop.poll(), 1u);
+    EXPECT_TRUE(stopped);
+    EXPECT_FALSE(value.has_value());
+
+    // The cancelled waiter no longer takes items.
+    queue.push(1);
+    EXPECT_EQ(queue.size(), 1u);
+}
+
+TEST(AsyncTest, StopTokenCancelsParkedPush) {
+    AsyncQueue<int> queue(1);
+    queue.push(0);
+    RunLoop loop;
+    StopSource source;
+    std::optional<bool> value;
+    bool stopped = false;
+
+    auto op = connect(async_push(queue, 1),
+                      TestReceiver<bool>{&loop, &value, &stopped, source.get_token()});
+    op.start();
+    source.request_stop();
+    loop.poll();
+    EXPECT_TRUE(stopped);
+
+    EXPECT_EQ(queue.pop(), std::optional<int>(0));
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(AsyncTest, WhenAnyTakesFromOneQueueOnly) {
+    AsyncQueue<int> a;
+    AsyncQueue<int> b;
+    RunLoop loop;
+    std::optional<std::pair<size_t, std::optional<int>>> value;
+    bool stopped = false;
+
+    auto op = connect(when_any(async_pop(a), async_pop(b)),
+                      TestReceiver<std::pair<size_t, std::optional<int>>>{
+                          &loop, &value, &stopped, {}});
+    op.start();
+    b.push(2);
+    a.push(1);  // The losing branch must not take this one
+    loop.poll();
+
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(value->first, 1u);
+    EXPECT_EQ(value->second, std::optional<int>(2));
+    EXPECT_EQ(a.size(), 1u);
+    EXPECT_EQ(b.size(), 0u);
+}
+
+TEST(AsyncTest, WhenAnyPrefersStoredItemAndReportsClose) {
+    AsyncQueue<int> a;
+    AsyncQueue<int> b;
+    b.push(7);
+    auto first = sync_wait(when_any(async_pop(a), async_pop(b)));
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->first, 1u);
+    EXPECT_EQ(first->second, std::optional<int>(7));
+
+    a.close();
+    auto closed = sync_wait(when_any(async_pop(a), async_pop(b)));
+    ASSERT_TRUE(closed.has_value());
+    EXPECT_EQ(closed->first, 0u);
+    EXPECT_FALSE(closed->second.has_value());
+}
+
+TEST(AsyncTest, ManyConcurrentWaitersGetEveryItem) {
+    AsyncQueue<int> queue;
+    RunLoop loop;
+    constexpr int count = 100;
+    int received = 0;
+
+    struct CountingReceiver {
+        RunLoop* loop;
+        int* received;
+        void set_value(std::optional<int> item) { *received += item ? 1 : 0; }
+        void set_stopped() {}
+        RunLoop::Scheduler get_scheduler() const { return loop->get_scheduler(); }
+    };
+
+    std::vector<std::optional<PopOperation<int, CountingReceiver>>> ops(count);
+    for (auto& op : ops) {
+        op.emplace(queue, CountingReceiver{&loop, &received});
+        op->start();
+    }
+    std::thread producer([&]() {
+        for (int i = 0; i < count; ++i) {
+            queue.push(i);
+        }
+        queue.close();
+    });
+    producer.join();
+    loop.poll();
+    EXPECT_EQ(received, count);
+}
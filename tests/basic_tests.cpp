@@ -250,3 +250,152 @@ TEST_F(AsyncQueueTest, TryPopSuccessful) {
 
     helper.join();
 }
+
+// A push hands the item directly to a consumer already blocked in pop(),
+// so a thread arriving later cannot take it first
+TEST_F(AsyncQueueTest, HandoffToParkedConsumer) {
+    std::optional<int> popped_value;
+
+    std::thread popper([&]() {
+        popped_value = queue.pop();
+    });
+
+    // Give the popper thread time to park
+    std::this_thread::sleep_for(50ms);
+    queue.push(42);
+
+    // The item already belongs to the parked consumer
+    EXPECT_FALSE(queue.try_pop(0ms).has_value());
+    EXPECT_TRUE(queue.empty());
+
+    popper.join();
+    ASSERT_TRUE(popped_value.has_value());
+    EXPECT_EQ(*popped_value, 42);
+}
+
+// Parked consumers are served in the order they arrived
+TEST_F(AsyncQueueTest, ParkedConsumersServedInOrder) {
+    std::optional<int> first, second;
+
+    std::thread t1([&]() { first = queue.pop(); });
+    std::this_thread::sleep_for(30ms);
+    std::thread t2([&]() { second = queue.pop(); });
+    std::this_thread::sleep_for(30ms);
+
+    queue.push(1);
+    queue.push(2);
+    t1.join();
+    t2.join();
+
+    EXPECT_EQ(*first, 1);
+    EXPECT_EQ(*second, 2);
+}
+
+// In fifo mode, blocked producers get freed slots in arrival order
+TEST_F(AsyncQueueTest, FifoFairnessServesProducersInOrder) {
+    AsyncQueue<int> fair_queue(1, Fairness::fifo);
+    EXPECT_EQ(fair_queue.fairness(), Fairness::fifo);
+    EXPECT_TRUE(fair_queue.push(0));
+
+    std::vector<std::thread> producers;
+    for (int i = 1; i <= 3; ++i) {
+        producers.emplace_back([&, i]() { fair_queue.push(i); });
+        std::this_thread::sleep_for(30ms);  // Park in a known order
+    }
+
+    // A late try_push may not overtake the parked producers
+    EXPECT_EQ(*fair_queue.pop(), 0);
+    EXPECT_FALSE(fair_queue.try_push(99, 10ms));
+
+    for (int i = 1; i <= 3; ++i) {
+        auto item = fair_queue.pop();
+        ASSERT_TRUE(item.has_value());
+        EXPECT_EQ(*item, i);
+    }
+    for (auto& p : producers) p.join();
+    EXPECT_TRUE(fair_queue.empty());
+}
+
+// Closing releases producers parked in fifo mode
+TEST_F(AsyncQueueTest, FifoFairnessCloseReleasesProducers) {
+    AsyncQueue<int> fair_queue(1, Fairness::fifo);
+    EXPECT_TRUE(fair_queue.push(0));
+
+    std::atomic<bool> push_result{true};
+    std::thread producer([&]() { push_result = fair_queue.push(1); });
+    std::this_thread::sleep_for(30ms);
+
+    fair_queue.close();
+    producer.join();
+    EXPECT_FALSE(push_result);
+    EXPECT_EQ(fair_queue.size(), 1);
+}
+
+// Freed capacity goes to the highest-priority blocked producer
+TEST_F(AsyncQueueTest, AdmissionPriority) {
+    AsyncQueue<int> bounded_queue(1);
+    EXPECT_TRUE(bounded_queue.push(0));
+
+    std::thread bulk([&]() { bounded_queue.push(1); });
+    std::this_thread::sleep_for(30ms);
+    std::thread control([&]() { bounded_queue.push(2, 10); });
+    std::this_thread::sleep_for(30ms);
+
+    EXPECT_EQ(*bounded_queue.pop(), 0);
+    EXPECT_EQ(*bounded_queue.pop(), 2);  // Control message admitted first
+    EXPECT_EQ(*bounded_queue.pop(), 1);
+
+    bulk.join();
+    control.join();
+}
+
+namespace {
+
+// Exposes how many producers are parked for granted slots.
+class ParkProbeQueue : public AsyncQueue<int> {
+public:
+    using AsyncQueue<int>::AsyncQueue;
+
+    size_t parked_producers() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t count = 0;
+        parked_producers_.for_each([&](const PushWaiter&) { ++count; });
+        return count;
+    }
+};
+
+} // namespace
+
+// Below the default priority a barging producer just competes; only higher
+// priorities are parked to be granted slots first.
+TEST_F(AsyncQueueTest, NegativePriorityDoesNotOutrankDefault) {
+    ParkProbeQueue bounded_queue(1);
+    EXPECT_TRUE(bounded_queue.push(0));
+
+    std::thread low([&]() { bounded_queue.push(1, -5); });
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(bounded_queue.parked_producers(), 0u);
+
+    std::thread high([&]() { bounded_queue.push(2, 5); });
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(bounded_queue.parked_producers(), 1u);
+
+    EXPECT_EQ(*bounded_queue.pop(), 0);
+    EXPECT_EQ(*bounded_queue.pop(), 2);
+    EXPECT_EQ(*bounded_queue.pop(), 1);
+    low.join();
+    high.join();
+}
+
+// Reserved slots only admit high-priority pushes
+TEST_F(AsyncQueueTest, ReservedCapacity) {
+    AsyncQueue<int> bounded_queue(3);
+    bounded_queue.reserve_capacity(1, 5);
+
+    EXPECT_TRUE(bounded_queue.try_push(1, 10ms));
+    EXPECT_TRUE(bounded_queue.try_push(2, 10ms));
+    EXPECT_FALSE(bounded_queue.try_push(3, 10ms));      // Only reserved slot left
+    EXPECT_TRUE(bounded_queue.try_push(4, 10ms, 5));    // Control traffic fits
+    EXPECT_FALSE(bounded_queue.try_push(5, 10ms, 5));   // Now truly full
+    EXPECT_EQ(bounded_queue.size(), 3);
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "async_queue/async_queue.hpp"
+#include <memory>
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(CancelTest, CancelPendingItem) {
+    AsyncQueue<int> queue;
+    auto h1 = queue.push_tracked(1);
+    auto h2 = queue.push_tracked(2);
+    auto h3 = queue.push_tracked(3);
+    ASSERT_TRUE(h1 && h2 && h3);
+
+    EXPECT_TRUE(queue.cancel(*h2));
+    EXPECT_FALSE(queue.cancel(*h2));  // Already cancelled
+    EXPECT_EQ(queue.size(), 2);
+
+    EXPECT_EQ(*queue.pop(), 1);
+    EXPECT_FALSE(queue.cancel(*h1));  // Already popped
+    EXPECT_EQ(*queue.pop(), 3);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(CancelTest, CancelFrontIsSkippedByConsumer) {
+    AsyncQueue<int> queue;
+    auto h = queue.push_tracked(1);
+    queue.push(2);
+
+    EXPECT_TRUE(queue.cancel(*h));
+    auto result = queue.try_pop(10ms);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 2);
+}
+
+TEST(CancelTest, CancelFreesCapacity) {
+    AsyncQueue<int> queue(1);
+    auto h = queue.push_tracked(1);
+    ASSERT_TRUE(h.has_value());
+    EXPECT_FALSE(queue.try_push(2, 10ms));
+
+    std::thread canceller([&]() {
+        std::this_thread::sleep_for(20ms);
+        queue.cancel(*h);
+    });
+    EXPECT_TRUE(queue.try_push(2, 500ms));
+    canceller.join();
+
+    EXPECT_EQ(*queue.pop(), 2);
+}
+
+TEST(CancelTest, CancelReleasesPayload) {
+    AsyncQueue<std::shared_ptr<int>> queue;
+    auto payload = std::make_shared<int>(7);
+    auto h = queue.push_tracked(payload);
+    EXPECT_EQ(payload.use_count(), 2);
+
+    queue.cancel(*h);
+    EXPECT_EQ(payload.use_count(), 1);
+}
+
+TEST(CancelTest, RemoveIfAndCompaction) {
+    AsyncQueue<int> queue;
+    for (int i = 0; i < 1000; ++i) {
+        queue.push(i);
+    }
+
+    // Keep only every fourth item; enough tombstones to force compaction
+    EXPECT_EQ(queue.remove_if([](int v) { return v % 4 != 3; }), 750u);
+    EXPECT_EQ(queue.size(), 250);
+
+    for (int i = 3; i < 1000; i += 4) {
+        auto item = queue.pop();
+        ASSERT_TRUE(item.has_value());
+        EXPECT_EQ(*item, i);
+    }
+    EXPECT_TRUE(queue.empty());
+}
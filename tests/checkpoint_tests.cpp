@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "async_queue/checkpoint.hpp"
+#include "async_queue/indexed_queue.hpp"
+#include <string>
+#include <vector>
+
+using namespace async_queue;
+
+namespace {
+
+void write_string(const std::string& s, std::vector<char>& out) {
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+std::string read_string(const char* data, size_t size) {
+    return std::string(data, size);
+}
+
+std::vector<char> checkpoint_of(AsyncQueue<std::string>& queue) {
+    std::vector<char> image;
+    snapshot(queue, write_string, [&](const char* data, size_t size) {
+        image.assign(data, data + size);
+    });
+    return image;
+}
+
+} // namespace
+
+TEST(CheckpointTest, RoundTripKeepsOrder) {
+    AsyncQueue<std::string> source;
+    source.push("alpha");
+    auto h = source.push_tracked("cancelled");
+    source.push("");
+    source.push("a longer item that spans several words");
+    ASSERT_TRUE(h);
+    source.cancel(*h);
+
+    auto image = checkpoint_of(source);
+    EXPECT_EQ(image.size() % 8, 0);
+    EXPECT_EQ(source.size(), 3);  // Snapshot leaves the queue untouched
+
+    AsyncQueue<std::string> target;
+    target.push("already here");
+    auto restored = restore(target, image.data(), image.size(), read_string);
+    ASSERT_TRUE(restored);
+    EXPECT_EQ(*restored, 3);
+
+    EXPECT_EQ(*target.pop(), "already here");
+    EXPECT_EQ(*target.pop(), "alpha");
+    EXPECT_EQ(*target.pop(), "");
+    EXPECT_EQ(*target.pop(), "a longer item that spans several words");
+    EXPECT_TRUE(target.empty());
+}
+
+TEST(CheckpointTest, EmptyQueue) {
+    AsyncQueue<std::string> source;
+    auto image = checkpoint_of(source);
+    EXPECT_EQ(image.size(), sizeof(CheckpointHeader));
+
+    AsyncQueue<std::string> target;
+    EXPECT_EQ(restore(target, image.data(), image.size(), read_string), 0u);
+}
+
+TEST(CheckpointTest, RejectsMalformedImage) {
+    AsyncQueue<std::string> source;
+    source.push("one");
+    source.push("two");
+    auto image = checkpoint_of(source);
+
+    AsyncQueue<std::string> target;
+    EXPECT_FALSE(restore(target, image.data(), image.size() - 8, read_string));
+    auto corrupt = image;
+    corrupt[0] = 'X';
+    EXPECT_FALSE(restore(target, corrupt.data(), corrupt.size(), read_string));
+    EXPECT_TRUE(target.empty());  // Nothing partially restored
+
+    target.close();
+    EXPECT_FALSE(restore(target, image.data(), image.size(), read_string));
+}
+
+TEST(CheckpointTest, RestoredItemsAreIndexed) {
+    AsyncQueue<std::string> source;
+    source.push("a1");
+    source.push("b1");
+    source.push("a2");
+    auto image = checkpoint_of(source);
+
+    auto first_char = [](const std::string& s) { return s[0]; };
+    IndexedAsyncQueue<std::string, decltype(first_char)> target(first_char);
+    ASSERT_TRUE(restore(target, image.data(), image.size(), read_string));
+    EXPECT_EQ(*target.pop_key('b'), "b1");
+    EXPECT_EQ(*target.pop_key('a'), "a1");
+}
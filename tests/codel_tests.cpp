@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "async_queue/async_queue.hpp"
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(CoDelTest, NoDropsWhileDelayIsLow) {
+    AsyncQueue<int> queue;
+    queue.set_codel(CoDelPolicy{5ms, 20ms});
+    for (int i = 0; i < 100; ++i) {
+        queue.push(i);
+        queue.push(i);
+        EXPECT_EQ(*queue.pop(), i);
+        EXPECT_EQ(*queue.pop(), i);
+    }
+    EXPECT_EQ(queue.stats().dropped, 0u);
+}
+
+TEST(CoDelTest, DropsStaleItemsUnderStandingQueue) {
+    AsyncQueue<int> queue;
+    std::vector<int> dropped;
+    queue.set_codel(CoDelPolicy{1ms, 10ms}, [&](int item) {
+        dropped.push_back(item);
+    });
+
+    for (int i = 0; i < 50; ++i) {
+        queue.push(i);
+    }
+    std::this_thread::sleep_for(5ms);
+    // First dequeue above target only starts the interval clock.
+    EXPECT_EQ(*queue.pop(), 0);
+    std::this_thread::sleep_for(15ms);
+
+    std::vector<int> served;
+    while (auto item = queue.try_pop(0ms)) {
+        served.push_back(*item);
+    }
+
+    EXPECT_FALSE(dropped.empty());
+    EXPECT_EQ(queue.stats().dropped, dropped.size());
+    EXPECT_EQ(served.size() + dropped.size(), 49u);
+    EXPECT_EQ(dropped.front(), 1);  // Oldest items go first
+    EXPECT_EQ(served.back(), 49);   // The last item is never dropped
+}
+
+TEST(CoDelTest, DropHandlerCanDivertItems) {
+    AsyncQueue<int> queue;
+    AsyncQueue<int> overflow;
+    queue.set_codel(CoDelPolicy{1ms, 5ms}, [&](int item) {
+        overflow.push(item);
+    });
+
+    for (int i = 0; i < 20; ++i) {
+        queue.push(i);
+    }
+    std::this_thread::sleep_for(5ms);
+    queue.pop();
+    std::this_thread::sleep_for(10ms);
+    while (queue.try_pop(0ms)) {
+    }
+
+    EXPECT_GT(overflow.size(), 0u);
+    EXPECT_EQ(overflow.size(), queue.stats().dropped);
+}
+
+TEST(CoDelTest, DropHandlerRunsOutsideLock) {
+    AsyncQueue<int> queue;
+    std::vector<int> dropped;
+    queue.set_codel(CoDelPolicy{1ms, 5ms}, [&](int item) {
+        // size() takes the queue's lock, so this hangs if the handler is
+        // called with it held.
+        EXPECT_LT(queue.size(), 20u);
+        dropped.push_back(item);
+    });
+
+    for (int i = 0; i < 20; ++i) {
+        queue.push(i);
+    }
+    std::this_thread::sleep_for(5ms);
+    queue.pop();
+    std::this_thread::sleep_for(10ms);
+    size_t served = 0;
+    while (queue.try_pop(0ms)) {
+        ++served;
+    }
+
+    EXPECT_FALSE(dropped.empty());
+    EXPECT_EQ(dropped.size(), queue.stats().dropped);
+    EXPECT_EQ(served + dropped.size(), 19u);
+}
+
+TEST(CoDelTest, DisabledQueueKeepsEverything) {
+    AsyncQueue<int> queue;
+    queue.set_codel(CoDelPolicy{1ms, 5ms});
+    queue.disable_codel();
+    for (int i = 0; i < 10; ++i) {
+        queue.push(i);
+    }
+    std::this_thread::sleep_for(20ms);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(*queue.pop(), i);
+    }
+    EXPECT_EQ(queue.stats().dropped, 0u);
+}
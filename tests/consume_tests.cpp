@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+#include "async_queue/async_queue.hpp"
+#include "async_queue/indexed_queue.hpp"
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Keyed {
+    int key;
+    int value;
+};
+
+struct KeyOf {
+    int operator()(const Keyed& k) const { return k.key; }
+};
+
+} // namespace
+
+TEST(ConsumeTest, RangeForDrainsClosedQueue) {
+    AsyncQueue<int> queue;
+    for (int i = 0; i < 10; ++i) {
+        queue.push(i);
+    }
+    queue.close();
+
+    std::vector<int> seen;
+    for (int item : queue.consume(3)) {
+        seen.push_back(item);
+    }
+    ASSERT_EQ(seen.size(), 10u);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(seen[i], i);
+    }
+}
+
+TEST(ConsumeTest, EndsWhenProducerCloses) {
+    AsyncQueue<std::unique_ptr<int>> queue(4);
+    std::thread producer([&]() {
+        for (int i = 0; i < 100; ++i) {
+            queue.push(std::make_unique<int>(i));
+        }
+        queue.close();
+    });
+
+    int expected = 0;
+    for (auto& item : queue.consume(8)) {
+        EXPECT_EQ(*item, expected++);
+    }
+    EXPECT_EQ(expected, 100);
+    producer.join();
+}
+
+TEST(ConsumeTest, EarlyBreakRequeuesRestOfBatch) {
+    AsyncQueue<int> queue;
+    for (int i = 0; i < 6; ++i) {
+        queue.push(i);
+    }
+
+    for (int item : queue.consume(4)) {
+        if (item == 1) {
+            break;
+        }
+    }
+    EXPECT_EQ(queue.size(), 4u);
+    for (int i = 2; i < 6; ++i) {
+        EXPECT_EQ(queue.try_pop(0ms), std::optional<int>(i));
+    }
+}
+
+TEST(ConsumeTest, PopBulkTakesWhatIsStored) {
+    AsyncQueue<int> queue(8);
+    for (int i = 0; i < 5; ++i) {
+        queue.push(i);
+    }
+
+    std::vector<int> out;
+    EXPECT_EQ(queue.pop_bulk(std::back_inserter(out), 3), 3u);
+    EXPECT_EQ(queue.pop_bulk(std::back_inserter(out), 10), 2u);
+    EXPECT_EQ(out, (std::vector<int>{0, 1, 2, 3, 4}));
+
+    EXPECT_EQ(queue.try_pop_bulk(std::back_inserter(out), 10, 10ms), 0u);
+    queue.close();
+    EXPECT_EQ(queue.pop_bulk(std::back_inserter(out), 10), 0u);
+}
+
+TEST(ConsumeTest, PopBulkWakesBlockedProducers) {
+    AsyncQueue<int> queue(2);
+    queue.push(0);
+    queue.push(1);
+
+    std::vector<std::thread> producers;
+    for (int i = 2; i < 4; ++i) {
+        producers.emplace_back([&queue, i]() {
+            queue.push(i);
+        });
+    }
+    std::this_thread::sleep_for(20ms);
+
+    std::vector<int> out;
+    EXPECT_EQ(queue.pop_bulk(std::back_inserter(out), 2), 2u);
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(queue.size(), 2u);
+}
+
+TEST(ConsumeTest, PopBulkReceivesHandoff) {
+    AsyncQueue<int> queue;
+    std::thread producer([&]() {
+        std::this_thread::sleep_for(20ms);
+        queue.push(7);
+    });
+
+    std::vector<int> out;
+    EXPECT_EQ(queue.pop_bulk(std::back_inserter(out), 4), 1u);
+    EXPECT_EQ(out, std::vector<int>{7});
+    producer.join();
+}
+
+TEST(ConsumeTest, UnreadHandoffRequeuesInOrder) {
+    AsyncQueue<int> queue;
+    queue.set_adaptive_lifo(10s);
+    {
+        auto range = queue.consume(4);
+        std::thread producer([&]() {
+            std::this_thread::sleep_for(20ms);
+            queue.push(1);
+        });
+        auto it = range.begin();
+        EXPECT_FALSE(it == range.end());  // Parks, then receives 1 by handoff
+        producer.join();
+        queue.push(2);
+    }  // 1 was never read, so it goes back in front of 2
+
+    auto handle = queue.push_tracked(3);
+    ASSERT_TRUE(handle);
+    EXPECT_TRUE(queue.cancel(*handle));
+    queue.push(4);
+    // Nothing has waited anywhere near the LIFO threshold.
+    EXPECT_EQ(queue.try_pop(0ms), std::optional<int>(1));
+    EXPECT_EQ(queue.try_pop(0ms), std::optional<int>(2));
+    EXPECT_EQ(queue.try_pop(0ms), std::optional<int>(4));
+}
+
+TEST(ConsumeTest, RequeuedItemsAreIndexedAgain) {
+    IndexedAsyncQueue<Keyed, KeyOf> queue;
+    queue.push(Keyed{1, 10});
+    queue.push(Keyed{2, 20});
+    {
+        auto range = queue.consume(2);
+        EXPECT_FALSE(range.begin() == range.end());  // Holds both, unread
+        queue.push(Keyed{3, 30});
+    }
+
+    auto first = queue.try_pop_key(1, 0ms);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->value, 10);
+    EXPECT_EQ(queue.try_pop_key(2, 0ms)->value, 20);
+    EXPECT_EQ(queue.try_pop_key(3, 0ms)->value, 30);
+}
+
+TEST(ConsumeTest, SelectiveWaiterSeesRequeuedMatch) {
+    AsyncQueue<int> queue;
+    queue.push(10);
+    queue.push(20);
+
+    std::optional<int> match;
+    {
+        auto range = queue.consume(2);
+        EXPECT_FALSE(range.begin() == range.end());
+        std::thread waiter([&]() {
+            match = queue.try_pop_if([](int v) { return v == 10; }, 2s);
+        });
+        std::this_thread::sleep_for(20ms);
+        queue.push(30);  // The waiter has scanned everything up to here
+        std::this_thread::sleep_for(20ms);
+        range = queue.consume(2);  // Drops the old batch, requeueing 10 and 20
+        waiter.join();
+    }
+    EXPECT_EQ(match, std::optional<int>(10));
+}
+
+TEST(ConsumeTest, BatchKeepsItsSlotsInBoundedQueue) {
+    AsyncQueue<int> queue(4);
+    for (int i = 0; i < 4; ++i) {
+        queue.push(i);
+    }
+    {
+        auto range = queue.consume(4);
+        EXPECT_FALSE(range.begin() == range.end());  // Holds all four, unread
+        EXPECT_EQ(queue.size(), 0u);
+        // Producers cannot take the slots the batch would need back.
+        std::thread producer([&]() {
+            EXPECT_FALSE(queue.try_push(4, 20ms));
+        });
+        producer.join();
+        EXPECT_FALSE(queue.try_push(5, 0ms));
+    }
+
+    EXPECT_EQ(queue.size(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(queue.try_pop(0ms), std::optional<int>(i));
+    }
+    EXPECT_TRUE(queue.try_push(6, 0ms));
+}
+
+TEST(ConsumeTest, CloseAndDrainWaitsForBatch) {
+    AsyncQueue<int> queue;
+    queue.push(0);
+    queue.push(1);
+    {
+        auto range = queue.consume(2);
+        EXPECT_FALSE(range.begin() == range.end());
+        EXPECT_FALSE(queue.close_and_drain(std::chrono::steady_clock::now() + 20ms));
+    }  // Both come back unread
+
+    EXPECT_EQ(queue.size(), 2u);
+    std::thread consumer([&]() {
+        for (int item : queue.consume(2)) {
+            (void)item;
+        }
+    });
+    EXPECT_TRUE(queue.close_and_drain(std::chrono::steady_clock::now() + 2s));
+    consumer.join();
+}
+
+TEST(ConsumeTest, AbortCancelsBatchGivenBack) {
+    AsyncQueue<int> queue;
+    for (int i = 0; i < 4; ++i) {
+        queue.push(i);
+    }
+    {
+        auto range = queue.consume(2);
+        EXPECT_FALSE(range.begin() == range.end());
+        auto pending = queue.abort();
+        EXPECT_EQ(pending.size(), 2u);
+    }
+
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_EQ(queue.try_pop(0ms), std::nullopt);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "async_queue/consumer_group.hpp"
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(ConsumerGroupTest, StatsTrackDepthAndDwell) {
+    AsyncQueue<int> queue;
+    EXPECT_EQ(queue.stats().depth, 0u);
+
+    queue.push(1);
+    queue.push(2);
+    EXPECT_EQ(queue.stats().depth, 2u);
+
+    std::this_thread::sleep_for(20ms);
+    queue.pop();
+    queue.pop();
+    auto stats = queue.stats();
+    EXPECT_EQ(stats.depth, 0u);
+    EXPECT_GT(stats.dwell, 1ms);
+}
+
+TEST(ConsumerGroupTest, HandlesEveryItemAndExitsOnClose) {
+    AsyncQueue<int> queue;
+    std::atomic<int> sum{0};
+    ScalingPolicy policy;
+    policy.min_threads = 2;
+    policy.max_threads = 4;
+    ConsumerGroup<int> group(queue, [&](int n) { sum += n; }, policy);
+
+    for (int i = 1; i <= 1000; ++i) {
+        queue.push(i);
+    }
+    queue.close_and_drain(std::chrono::steady_clock::now() + 5s);
+    group.stop();
+    EXPECT_EQ(sum, 500500);
+}
+
+TEST(ConsumerGroupTest, ScalesUpUnderBacklogAndBackDown) {
+    AsyncQueue<int> queue;
+    ScalingPolicy policy;
+    policy.min_threads = 1;
+    policy.max_threads = 4;
+    policy.depth_per_thread = 2;
+    policy.idle_timeout = 100ms;
+    policy.check_interval = 5ms;
+
+    std::atomic<size_t> peak{0};
+    ConsumerGroup<int> group(queue, [](int) { std::this_thread::sleep_for(10ms); }, policy);
+    for (int i = 0; i < 60; ++i) {
+        queue.push(i);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!queue.empty() && std::chrono::steady_clock::now() < deadline) {
+        peak = std::max(peak.load(), group.threads());
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT_EQ(peak, 4u);
+
+    // Idle workers above min_threads retire after idle_timeout.
+    while (group.threads() > 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(group.threads(), 1u);
+}
+
+TEST(ConsumerGroupTest, StopLeavesPendingItems) {
+    AsyncQueue<int> queue;
+    std::atomic<int> handled{0};
+    {
+        ScalingPolicy policy;
+        policy.max_threads = 1;
+        ConsumerGroup<int> group(queue, [&](int) {
+            ++handled;
+            std::this_thread::sleep_for(20ms);
+        }, policy);
+        for (int i = 0; i < 10; ++i) {
+            queue.push(i);
+        }
+        std::this_thread::sleep_for(30ms);
+    }
+    EXPECT_GT(handled, 0);
+    EXPECT_EQ(queue.size() + static_cast<size_t>(handled), 10u);
+    EXPECT_FALSE(queue.is_closed());
+}
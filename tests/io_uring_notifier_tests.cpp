@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include "async_queue/io_uring_notifier.hpp"
+#include <sys/mman.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Just enough of an io_uring to submit one SQE and wait for its CQE.
+class TestRing {
+    int fd_ = -1;
+    io_uring_params params_{};
+    void* sq_ = MAP_FAILED;
+    void* cq_ = MAP_FAILED;
+    io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sq_size_ = 0;
+    size_t cq_size_ = 0;
+
+    template<typename U>
+    U* at(void* base, uint32_t offset) {
+        return reinterpret_cast<U*>(static_cast<char*>(base) + offset);
+    }
+
+public:
+    TestRing() {
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, 4, &params_));
+        if (fd_ < 0) {
+            return;
+        }
+        sq_size_ = params_.sq_off.array + params_.sq_entries * sizeof(uint32_t);
+        cq_size_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+        sq_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                   IORING_OFF_SQ_RING);
+        cq_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                   IORING_OFF_CQ_RING);
+        sqes_ = static_cast<io_uring_sqe*>(
+            mmap(nullptr, params_.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+    }
+
+    ~TestRing() {
+        if (sqes_ != MAP_FAILED) munmap(sqes_, params_.sq_entries * sizeof(io_uring_sqe));
+        if (cq_ != MAP_FAILED) munmap(cq_, cq_size_);
+        if (sq_ != MAP_FAILED) munmap(sq_, sq_size_);
+        if (fd_ >= 0) close(fd_);
+    }
+
+    bool ok() const {
+        return fd_ >= 0 && sq_ != MAP_FAILED && cq_ != MAP_FAILED && sqes_ != MAP_FAILED;
+    }
+
+    int fd() const { return fd_; }
+
+    void submit(const io_uring_sqe& sqe) {
+        auto* tail = at<std::atomic<uint32_t>>(sq_, params_.sq_off.tail);
+        uint32_t mask = *at<uint32_t>(sq_, params_.sq_off.ring_mask);
+        uint32_t index = tail->load(std::memory_order_relaxed) & mask;
+        sqes_[index] = sqe;
+        at<uint32_t>(sq_, params_.sq_off.array)[index] = index;
+        tail->fetch_add(1, std::memory_order_release);
+        syscall(__NR_io_uring_enter, fd_, 1, 0, 0, nullptr, 0);
+    }
+
+    // Wait for one completion and return its user_data.
+    uint64_t wait() {
+        auto* head = at<std::atomic<uint32_t>>(cq_, params_.cq_off.head);
+        auto* tail = at<std::atomic<uint32_t>>(cq_, params_.cq_off.tail);
+        while (head->load(std::memory_order_relaxed) == tail->load(std::memory_order_acquire)) {
+            syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        }
+        uint32_t mask = *at<uint32_t>(cq_, params_.cq_off.ring_mask);
+        uint32_t h = head->load(std::memory_order_relaxed);
+        uint64_t data = at<io_uring_cqe>(cq_, params_.cq_off.cqes)[h & mask].user_data;
+        head->store(h + 1, std::memory_order_release);
+        return data;
+    }
+};
+
+struct CountingNotifier : ReadinessNotifier {
+    int count = 0;
+    void notify() override { ++count; }
+};
+
+// Event loop: drain the queue until it closes, sleeping on the ring.
+int run_loop(TestRing& ring, IoUringNotifier& notifier, AsyncQueue<int>& queue) {
+    int drained = 0;
+    for (;;) {
+        while (queue.try_pop(0ms)) {
+            ++drained;
+        }
+        if (queue.is_closed() && queue.empty()) {
+            return drained;
+        }
+        io_uring_sqe sqe;
+        if (notifier.arm(sqe, 42)) {
+            ring.submit(sqe);
+            EXPECT_EQ(ring.wait(), 42u);
+            notifier.consume();
+        }
+    }
+}
+
+void expect_loop_drains(IoUringNotifier::Mode mode) {
+    TestRing ring;
+    if (!ring.ok()) {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    if (mode == IoUringNotifier::Mode::futex && !IoUringNotifier::supports_futex_wait(ring.fd())) {
+        GTEST_SKIP() << "IORING_OP_FUTEX_WAIT unsupported";
+    }
+    IoUringNotifier notifier(mode);
+    AsyncQueue<int> queue(16);
+    queue.set_notifier(&notifier);
+
+    std::thread producer([&]() {
+        for (int i = 0; i < 1000; ++i) {
+            queue.push(i);
+            if (i % 100 == 0) {
+                std::this_thread::sleep_for(1ms);  // Let the loop go to sleep
+            }
+        }
+        queue.close();
+    });
+    EXPECT_EQ(run_loop(ring, notifier, queue), 1000);
+    producer.join();
+}
+
+} // namespace
+
+TEST(IoUringNotifierTest, QueueReportsStoredItemsAndClose) {
+    AsyncQueue<int> queue;
+    CountingNotifier notifier;
+    queue.push(1);
+    queue.set_notifier(&notifier);
+    EXPECT_EQ(notifier.count, 1);  // Already pending
+
+    queue.push(2);
+    EXPECT_EQ(notifier.count, 2);
+
+    queue.pop();
+    queue.pop();
+    std::thread consumer([&]() { queue.pop(); });
+    std::this_thread::sleep_for(20ms);
+    queue.push(3);  // Handed to the parked consumer
+    consumer.join();
+    EXPECT_EQ(notifier.count, 2);
+
+    queue.close();
+    EXPECT_EQ(notifier.count, 3);
+    queue.set_notifier(nullptr);
+}
+
+TEST(IoUringNotifierTest, CoalescesBurstIntoOneWakeup) {
+    IoUringNotifier notifier(IoUringNotifier::Mode::eventfd);
+    ASSERT_GE(notifier.eventfd(), 0);
+
+    io_uring_sqe sqe;
+    ASSERT_TRUE(notifier.arm(sqe, 7));
+    EXPECT_EQ(sqe.opcode, IORING_OP_READ);
+    EXPECT_EQ(sqe.fd, notifier.eventfd());
+    EXPECT_EQ(sqe.user_data, 7u);
+
+    for (int i = 0; i < 100; ++i) {
+        notifier.notify();
+    }
+    uint64_t counter = 0;
+    ASSERT_EQ(read(notifier.eventfd(), &counter, sizeof(counter)), 8);
+    EXPECT_EQ(counter, 1u);
+
+    // Notified before arming: drain again instead of waiting.
+    notifier.consume();
+    notifier.notify();
+    EXPECT_FALSE(notifier.arm(sqe, 7));
+    EXPECT_TRUE(notifier.arm(sqe, 7));
+    EXPECT_EQ(read(notifier.eventfd(), &counter, sizeof(counter)), -1);  // Nothing written
+}
+
+TEST(IoUringNotifierTest, LoopDrainsWithFutexWait) {
+    expect_loop_drains(IoUringNotifier::Mode::futex);
+}
+
+TEST(IoUringNotifierTest, LoopDrainsWithEventfd) {
+    expect_loop_drains(IoUringNotifier::Mode::eventfd);
+}
+
+TEST(IoUringNotifierTest, ProbesRing) {
+    TestRing ring;
+    if (!ring.ok()) {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    IoUringNotifier notifier(ring.fd());
+    EXPECT_EQ(notifier.mode() == IoUringNotifier::Mode::futex,
+              IoUringNotifier::supports_futex_wait(ring.fd()));
+    EXPECT_EQ(notifier.eventfd() >= 0, notifier.mode() == IoUringNotifier::Mode::eventfd);
+}
+
+#endif // __linux__
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "async_queue/mailbox.hpp"
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct State {
+    uint64_t a;
+    uint64_t b;
+    uint64_t c;
+};
+
+} // namespace
+
+TEST(MailboxTest, LatestValueWins) {
+    Mailbox<int> mailbox;
+    EXPECT_FALSE(mailbox.load().has_value());
+    EXPECT_EQ(mailbox.version(), 0u);
+
+    EXPECT_EQ(mailbox.publish(1), 1u);
+    EXPECT_EQ(mailbox.publish(2), 2u);
+
+    uint64_t version = 0;
+    auto value = mailbox.load(version);
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, 2);
+    EXPECT_EQ(version, 2u);
+}
+
+TEST(MailboxTest, WaitForUpdate) {
+    Mailbox<int> mailbox;
+    uint64_t version = 0;
+
+    std::thread writer([&]() {
+        std::this_thread::sleep_for(20ms);
+        mailbox.publish(7);
+    });
+
+    auto value = mailbox.wait_for_update(version);
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, 7);
+    EXPECT_EQ(version, 1u);
+    writer.join();
+
+    // Nothing newer than what we saw
+    EXPECT_FALSE(mailbox.try_wait_for_update(version, 20ms).has_value());
+}
+
+TEST(MailboxTest, CloseReleasesWaiters) {
+    Mailbox<int> mailbox;
+    uint64_t version = 0;
+
+    std::thread closer([&]() {
+        std::this_thread::sleep_for(20ms);
+        mailbox.close();
+    });
+
+    EXPECT_FALSE(mailbox.wait_for_update(version).has_value());
+    closer.join();
+}
+
+TEST(MailboxTest, NonTrivialType) {
+    Mailbox<std::string> mailbox;
+    mailbox.publish("first");
+    mailbox.publish(std::string(100, 'x'));
+
+    auto value = mailbox.load();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, std::string(100, 'x'));
+    EXPECT_EQ(mailbox.version(), 2u);
+}
+
+TEST(MailboxTest, ReadsAreNeverTorn) {
+    Mailbox<State> mailbox;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&]() {
+        for (uint64_t i = 1; i <= 100000; ++i) {
+            mailbox.publish(State{i, i, i});
+        }
+        done = true;
+    });
+
+    uint64_t last = 0;
+    while (!done) {
+        if (auto s = mailbox.load()) {
+            ASSERT_EQ(s->a, s->b);
+            ASSERT_EQ(s->b, s->c);
+            ASSERT_GE(s->a, last);
+            last = s->a;
+        }
+    }
+    writer.join();
+    EXPECT_EQ(mailbox.load()->a, 100000u);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "async_queue/merge_queue.hpp"
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(MergeQueueTest, MergesSortedLanes) {
+    MergeQueue<int> queue(3);
+    for (int v : {1, 4, 7}) queue.push(0, v);
+    for (int v : {2, 5, 8}) queue.push(1, v);
+    for (int v : {3, 6, 9}) queue.push(2, v);
+    queue.close();
+
+    for (int expected = 1; expected <= 9; ++expected) {
+        auto item = queue.pop();
+        ASSERT_TRUE(item.has_value());
+        EXPECT_EQ(*item, expected);
+    }
+    EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST(MergeQueueTest, BlocksWhileOpenLaneIsEmpty) {
+    MergeQueue<int> queue(2);
+    queue.push(0, 10);
+
+    // Lane 1 is open and empty, so 10 might not be the smallest yet
+    EXPECT_FALSE(queue.try_pop(30ms).has_value());
+
+    queue.push(1, 5);
+    EXPECT_EQ(*queue.try_pop(30ms), 5);
+
+    // Closing the empty lane releases the watermark
+    queue.close(1);
+    EXPECT_EQ(*queue.try_pop(30ms), 10);
+}
+
+TEST(MergeQueueTest, ClosedLaneRejectsPush) {
+    MergeQueue<int> queue(2);
+    queue.close(0);
+    EXPECT_FALSE(queue.push(0, 1));
+    EXPECT_TRUE(queue.push(1, 1));
+    EXPECT_FALSE(queue.is_closed());
+}
+
+TEST(MergeQueueTest, ConcurrentProducersProduceGlobalOrder) {
+    constexpr int LANES = 5;
+    constexpr int ITEMS = 2000;
+    MergeQueue<int> queue(LANES, 16);
+
+    std::vector<std::thread> producers;
+    for (int lane = 0; lane < LANES; ++lane) {
+        producers.emplace_back([&, lane]() {
+            for (int i = 0; i < ITEMS; ++i) {
+                queue.push(lane, i * LANES + lane);
+            }
+            queue.close(lane);
+        });
+    }
+
+    int expected = 0;
+    while (auto item = queue.pop()) {
+        ASSERT_EQ(*item, expected);
+        ++expected;
+    }
+    EXPECT_EQ(expected, LANES * ITEMS);
+
+    for (auto& p : producers) p.join();
+}
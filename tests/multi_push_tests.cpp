@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "async_queue/multi_push.hpp"
+#include <memory>
+#include <string>
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(MultiPushTest, PushesIntoAllQueues) {
+    AsyncQueue<int> work;
+    AsyncQueue<std::string> audit;
+
+    auto tx = make_push_transaction(push_entry(work, 1), push_entry(audit, "job 1"));
+    EXPECT_TRUE(push_all(tx));
+    EXPECT_TRUE(tx.committed());
+    EXPECT_FALSE(push_all(tx));  // A transaction commits once
+
+    EXPECT_EQ(*work.pop(), 1);
+    EXPECT_EQ(*audit.pop(), "job 1");
+}
+
+TEST(MultiPushTest, NothingPushedWhenOneQueueIsFull) {
+    AsyncQueue<int> work;
+    AsyncQueue<int> audit(1);
+    audit.push(0);
+
+    auto tx = make_push_transaction(push_entry(work, 1), push_entry(audit, 2));
+    EXPECT_FALSE(try_push_all(tx, 20ms));
+    EXPECT_TRUE(work.empty());
+    EXPECT_EQ(tx.item<0>(), 1);
+
+    // Room appears in the full queue while waiting
+    std::thread consumer([&]() {
+        std::this_thread::sleep_for(20ms);
+        audit.pop();
+    });
+    EXPECT_TRUE(try_push_all(tx, 1s));
+    consumer.join();
+
+    EXPECT_EQ(*work.pop(), 1);
+    EXPECT_EQ(*audit.pop(), 2);
+}
+
+TEST(MultiPushTest, NothingPushedWhenOneQueueIsClosed) {
+    AsyncQueue<std::unique_ptr<int>> work;
+    AsyncQueue<int> audit;
+    audit.close();
+
+    auto tx = make_push_transaction(push_entry(work, std::make_unique<int>(5)),
+                                    push_entry(audit, 5));
+    EXPECT_FALSE(push_all(tx));
+    EXPECT_TRUE(work.empty());
+    ASSERT_TRUE(tx.item<0>());  // Move-only item is not lost
+    EXPECT_EQ(*tx.item<0>(), 5);
+}
+
+TEST(MultiPushTest, SameQueueTwiceNeedsTwoSlots) {
+    AsyncQueue<int> queue(2);
+    queue.push(0);
+
+    auto tx = make_push_transaction(push_entry(queue, 1), push_entry(queue, 2));
+    EXPECT_FALSE(try_push_all(tx, 10ms));
+    EXPECT_EQ(queue.size(), 1);
+
+    queue.pop();
+    EXPECT_TRUE(try_push_all(tx, 10ms));
+    EXPECT_EQ(*queue.pop(), 1);
+    EXPECT_EQ(*queue.pop(), 2);
+}
+
+TEST(MultiPushTest, ReservedSlotsDoNotCount) {
+    AsyncQueue<int> queue(3);
+    queue.reserve_capacity(2, 1);
+
+    // Only one slot is open to priority 0, so this can never fit.
+    auto tx = make_push_transaction(push_entry(queue, 1), push_entry(queue, 2));
+    EXPECT_FALSE(push_all(tx));
+    EXPECT_EQ(queue.size(), 0);
+
+    queue.reserve_capacity(1, 1);
+    EXPECT_TRUE(push_all(tx));
+}
+
+TEST(MultiPushTest, OppositeOrderTransactionsDoNotDeadlock) {
+    AsyncQueue<int> a(4);
+    AsyncQueue<int> b(4);
+    constexpr int ITEMS = 2000;
+
+    std::thread consumer([&]() {
+        for (int i = 0; i < 2 * ITEMS; ++i) {
+            a.pop();
+            b.pop();
+        }
+    });
+    std::thread t1([&]() {
+        for (int i = 0; i < ITEMS; ++i) {
+            auto tx = make_push_transaction(push_entry(a, i), push_entry(b, i));
+            push_all(tx);
+        }
+    });
+    std::thread t2([&]() {
+        for (int i = 0; i < ITEMS; ++i) {
+            auto tx = make_push_transaction(push_entry(b, i), push_entry(a, i));
+            push_all(tx);
+        }
+    });
+
+    t1.join();
+    t2.join();
+    consumer.join();
+    EXPECT_TRUE(a.empty());
+    EXPECT_TRUE(b.empty());
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "async_queue/oneshot.hpp"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+static_assert(sizeof(Oneshot<int>) <= 64, "small oneshot fits in a cache line");
+
+TEST(OneshotTest, PushThenPop) {
+    Oneshot<std::string> slot;
+    EXPECT_TRUE(slot.push("done"));
+    EXPECT_FALSE(slot.push("again"));  // Single value only
+    EXPECT_TRUE(slot.ready());
+
+    auto value = slot.pop();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, "done");
+    EXPECT_FALSE(slot.try_pop(1ms).has_value());  // Already taken
+}
+
+TEST(OneshotTest, BlockingPopWakesOnPush) {
+    Oneshot<std::unique_ptr<int>> slot;
+
+    std::thread sender([&]() {
+        std::this_thread::sleep_for(20ms);
+        slot.push(std::make_unique<int>(42));
+    });
+
+    auto value = slot.pop();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(**value, 42);
+    sender.join();
+}
+
+TEST(OneshotTest, CloseWakesReceiver) {
+    Oneshot<int> slot;
+
+    std::thread sender([&]() {
+        std::this_thread::sleep_for(20ms);
+        slot.close();
+    });
+
+    EXPECT_FALSE(slot.pop().has_value());
+    EXPECT_TRUE(slot.is_closed());
+    EXPECT_FALSE(slot.push(1));
+    sender.join();
+}
+
+TEST(OneshotTest, ValueSurvivesClose) {
+    Oneshot<int> slot;
+    slot.push(7);
+    slot.close();
+    EXPECT_EQ(*slot.pop(), 7);
+}
+
+TEST(OneshotTest, TryPopTimesOut) {
+    Oneshot<int> slot;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(slot.try_pop(50ms).has_value());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 45ms);
+}
+
+TEST(OneshotTest, UnpoppedValueIsDestroyed) {
+    auto payload = std::make_shared<int>(1);
+    {
+        Oneshot<std::shared_ptr<int>> slot;
+        slot.push(payload);
+        EXPECT_EQ(payload.use_count(), 2);
+    }
+    EXPECT_EQ(payload.use_count(), 1);
+}
+
+TEST(OneshotTest, ThrowingConstructorLeavesChannelEmpty) {
+    struct Fragile {
+        explicit Fragile(int v) : value(v) {
+            if (v < 0) {
+                throw std::runtime_error("bad value");
+            }
+        }
+        int value;
+    };
+
+    Oneshot<Fragile> slot;
+    EXPECT_THROW(slot.push(-1), std::runtime_error);
+    EXPECT_FALSE(slot.ready());
+
+    std::thread sender([&]() {
+        std::this_thread::sleep_for(20ms);
+        slot.close();
+    });
+    EXPECT_FALSE(slot.pop().has_value());
+    EXPECT_TRUE(slot.is_closed());
+    sender.join();
+}
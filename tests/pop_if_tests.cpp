@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include "async_queue/async_queue.hpp"
+#include "async_queue/indexed_queue.hpp"
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Message {
+    int id;
+    int value;
+};
+
+struct MessageId {
+    int operator()(const Message& m) const { return m.id; }
+};
+
+} // namespace
+
+TEST(PopIfTest, RemovesFirstMatchPreservingOrder) {
+    AsyncQueue<int> queue;
+    for (int i = 1; i <= 5; ++i) {
+        queue.push(i);
+    }
+
+    auto even = queue.pop_if([](int v) { return v % 2 == 0; });
+    ASSERT_TRUE(even.has_value());
+    EXPECT_EQ(*even, 2);
+    EXPECT_EQ(queue.size(), 4);
+
+    // Remaining items come out in their original order
+    EXPECT_EQ(*queue.pop(), 1);
+    EXPECT_EQ(*queue.pop(), 3);
+    EXPECT_EQ(*queue.pop(), 4);
+    EXPECT_EQ(*queue.pop(), 5);
+}
+
+TEST(PopIfTest, TimesOutWithoutMatch) {
+    AsyncQueue<int> queue;
+    queue.push(1);
+
+    auto result = queue.try_pop_if([](int v) { return v == 2; }, 50ms);
+    EXPECT_FALSE(result.has_value());
+    EXPECT_EQ(queue.size(), 1);
+}
+
+TEST(PopIfTest, WaitsForMatchingPush) {
+    AsyncQueue<int> queue;
+    std::optional<int> result;
+
+    std::thread waiter([&]() {
+        result = queue.pop_if([](int v) { return v > 10; });
+    });
+
+    queue.push(1);
+    std::this_thread::sleep_for(50ms);
+    queue.push(42);
+    waiter.join();
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 42);
+    EXPECT_EQ(*queue.pop(), 1);
+}
+
+TEST(PopIfTest, CloseWakesSelectiveWaiter) {
+    AsyncQueue<int> queue;
+    queue.push(1);
+
+    std::thread closer([&]() {
+        std::this_thread::sleep_for(50ms);
+        queue.close();
+    });
+
+    EXPECT_FALSE(queue.pop_if([](int v) { return v == 2; }).has_value());
+    closer.join();
+
+    // Non-matching items are still drained after close
+    EXPECT_EQ(*queue.pop(), 1);
+}
+
+TEST(IndexedQueueTest, PopKeyUsesIndex) {
+    IndexedAsyncQueue<Message, MessageId> queue;
+    queue.push(Message{1, 10});
+    queue.push(Message{2, 20});
+    queue.push(Message{1, 11});
+
+    auto m = queue.pop_key(2);
+    ASSERT_TRUE(m.has_value());
+    EXPECT_EQ(m->value, 20);
+
+    // Plain pop keeps the index consistent
+    EXPECT_EQ(queue.pop()->value, 10);
+
+    m = queue.pop_key(1);
+    ASSERT_TRUE(m.has_value());
+    EXPECT_EQ(m->value, 11);
+
+    EXPECT_FALSE(queue.try_pop_key(1, 20ms).has_value());
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(IndexedQueueTest, PopKeyAfterPopIf) {
+    IndexedAsyncQueue<Message, MessageId> queue;
+    queue.push(Message{3, 1});
+    queue.push(Message{3, 2});
+
+    auto m = queue.pop_if([](const Message& msg) { return msg.value == 2; });
+    ASSERT_TRUE(m.has_value());
+
+    m = queue.pop_key(3);
+    ASSERT_TRUE(m.has_value());
+    EXPECT_EQ(m->value, 1);
+    EXPECT_FALSE(queue.try_pop_key(3, 10ms).has_value());
+}
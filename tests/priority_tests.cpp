@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "async_queue/priority_queue.hpp"
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(PriorityQueueTest, HigherPriorityFirst) {
+    PriorityAsyncQueue<int> queue(AgingPolicy{4, std::chrono::hours(1)});
+    queue.push(1, 0);
+    queue.push(2, 3);
+    queue.push(3, 1);
+    queue.push(4, 3);
+
+    EXPECT_EQ(*queue.pop(), 2);
+    EXPECT_EQ(*queue.pop(), 4);  // FIFO within a level
+    EXPECT_EQ(*queue.pop(), 3);
+    EXPECT_EQ(*queue.pop(), 1);
+}
+
+TEST(PriorityQueueTest, AgingPromotesWaitingItems) {
+    PriorityAsyncQueue<int> queue(AgingPolicy{4, 10ms});
+    queue.push(0, 0);
+    std::this_thread::sleep_for(50ms);  // Aged past the top level
+
+    // A fresh high-priority item now ties with the aged one; the older wins
+    queue.push(3, 3);
+    EXPECT_EQ(*queue.pop(), 0);
+    EXPECT_EQ(*queue.pop(), 3);
+}
+
+TEST(PriorityQueueTest, ZeroIntervalDisablesAging) {
+    PriorityAsyncQueue<int> queue(AgingPolicy{2, std::chrono::nanoseconds(0)});
+    queue.push(0, 0);
+    std::this_thread::sleep_for(10ms);
+    queue.push(1, 1);
+    EXPECT_EQ(*queue.pop(), 1);
+    EXPECT_EQ(*queue.pop(), 0);
+}
+
+TEST(PriorityQueueTest, CapacityAndClose) {
+    PriorityAsyncQueue<int> queue(AgingPolicy{}, 1);
+    EXPECT_TRUE(queue.push(1, 7));
+    EXPECT_FALSE(queue.try_push(2, 0, 20ms));
+
+    queue.close();
+    EXPECT_FALSE(queue.push(3, 0));
+    EXPECT_EQ(*queue.pop(), 1);
+    EXPECT_FALSE(queue.try_pop(10ms).has_value());
+}
+
+TEST(PriorityQueueTest, WaitHistogramRecordsPops) {
+    PriorityAsyncQueue<int> queue;
+    queue.push(1, 2);
+    queue.push(2, 2);
+    queue.pop();
+    queue.pop();
+
+    auto hist = queue.wait_histogram(2);
+    EXPECT_EQ(hist.count, 2u);
+    EXPECT_EQ(queue.wait_histogram(0).count, 0u);
+}
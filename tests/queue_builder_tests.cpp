@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "async_queue/queue_builder.hpp"
+#include <thread>
+#include <type_traits>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+using SpscSpin = make_queue_type<int>::producers<opt::single>::consumers<opt::single>
+                     ::bounded<64>::wait<opt::spin_then_park>::type;
+using SpscPark = make_queue_type<int>::bounded<64>::consumers<opt::single>
+                     ::producers<opt::single>::type;
+using Mpmc = make_queue_type<int>::type;
+using MpscBounded = make_queue_type<int>::producers<opt::multi>::consumers<opt::single>
+                        ::bounded<16>::type;
+using SpscUnbounded = make_queue_type<int>::producers<opt::single>::consumers<opt::single>::type;
+using Prioritized = make_queue_type<int>::order<opt::by_priority>::bounded<8>::type;
+
+static_assert(std::is_same_v<SpscSpin::backend, SpscQueue<int, opt::spin_then_park>>);
+static_assert(std::is_same_v<SpscPark::backend, SpscQueue<int, opt::park>>);
+static_assert(std::is_same_v<Mpmc::backend, AsyncQueue<int>>);
+static_assert(std::is_same_v<MpscBounded::backend, AsyncQueue<int>>);
+static_assert(std::is_same_v<SpscUnbounded::backend, AsyncQueue<int>>);
+static_assert(std::is_same_v<Prioritized::backend, detail::PriorityBackend<int>>);
+
+namespace {
+
+// One call site, compiled against every resolved type.
+template<typename Queue>
+void exercise() {
+    Queue queue;
+    int seen = 0;
+    std::thread producer([&]() {
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_TRUE(queue.push(i));
+        }
+        queue.close();
+    });
+    while (auto item = queue.pop()) {
+        EXPECT_EQ(*item, seen++);
+    }
+    producer.join();
+    EXPECT_EQ(seen, 1000);
+    EXPECT_TRUE(queue.is_closed());
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.try_push(1, 1ms));
+    EXPECT_FALSE(queue.try_pop(1ms).has_value());
+}
+
+} // namespace
+
+TEST(QueueBuilderTest, EveryResolutionSharesTheInterface) {
+    exercise<SpscSpin>();
+    exercise<SpscPark>();
+    exercise<Mpmc>();
+    exercise<MpscBounded>();
+    exercise<SpscUnbounded>();
+    exercise<Prioritized>();
+}
+
+TEST(QueueBuilderTest, CapacityComesFromTheBuilder) {
+    EXPECT_EQ(SpscSpin().capacity(), 64u);
+    EXPECT_EQ(MpscBounded().capacity(), 16u);
+    EXPECT_EQ(Prioritized().capacity(), 8u);
+    EXPECT_EQ(Mpmc().capacity(), std::numeric_limits<size_t>::max());
+
+    MpscBounded queue;
+    for (int i = 0; i < 16; ++i) {
+        EXPECT_TRUE(queue.try_push(i, 1ms));
+    }
+    EXPECT_FALSE(queue.try_push(16, 1ms));
+}
+
+TEST(QueueBuilderTest, PriorityResolutionKeepsPriorities) {
+    Prioritized queue;
+    queue.push(1);
+    queue.push(2, 3);
+    EXPECT_TRUE(queue.try_push(3, 1ms, 1));
+    EXPECT_EQ(queue.pop(), std::optional<int>(2));
+    EXPECT_EQ(queue.pop(), std::optional<int>(3));
+    EXPECT_EQ(queue.pop(), std::optional<int>(1));
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "async_queue/queue_pool.hpp"
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(QueuePoolTest, ResetReopensClosedQueue) {
+    AsyncQueue<int> queue(4);
+    auto stale = queue.push_tracked(1);
+    queue.push(2);
+    queue.close();
+    EXPECT_FALSE(queue.push(3));
+
+    EXPECT_TRUE(queue.reset());
+    EXPECT_FALSE(queue.is_closed());
+    EXPECT_TRUE(queue.empty());
+
+    EXPECT_TRUE(queue.push(4));
+    ASSERT_TRUE(stale);
+    EXPECT_FALSE(queue.cancel(*stale));  // Old handles never match new items
+    EXPECT_EQ(*queue.pop(), 4);
+}
+
+TEST(QueuePoolTest, ResetRestoresDefaultSettings) {
+    struct CountingNotifier : ReadinessNotifier {
+        int calls = 0;
+        void notify() override { ++calls; }
+    };
+
+    AsyncQueue<int> queue(4);
+    bool dropped = false;
+    queue.set_codel(CoDelPolicy{1ms, 2ms}, [&](int) { dropped = true; });
+    queue.set_adaptive_lifo(1ms);
+    queue.push(10);
+    queue.push(11);
+    std::this_thread::sleep_for(5ms);
+    queue.try_pop(0ms);
+    queue.try_pop(0ms);
+    EXPECT_GT(queue.stats().dwell.count(), 0);
+    CountingNotifier notifier;
+    queue.set_notifier(&notifier);
+    queue.reserve_capacity(4, 1);
+    ASSERT_TRUE(queue.reset());
+
+    // Nothing carries over from the previous user's traffic.
+    QueueStats stats = queue.stats();
+    EXPECT_EQ(stats.dwell.count(), 0);
+    EXPECT_EQ(stats.dropped, 0u);
+    LifoStats lifo = queue.lifo_stats();
+    EXPECT_FALSE(lifo.lifo);
+    EXPECT_EQ(lifo.fifo_time.count(), 0);
+    EXPECT_EQ(lifo.lifo_time.count(), 0);
+    EXPECT_EQ(lifo.switches, 0u);
+    dropped = false;
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.try_push(i, 0ms));  // No slots held back any more
+    }
+    std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(queue.try_pop(0ms), std::optional<int>(0));  // FIFO despite the backlog
+    std::this_thread::sleep_for(10ms);
+    for (int i = 1; i < 4; ++i) {
+        EXPECT_EQ(queue.try_pop(0ms), std::optional<int>(i));  // CoDel is off
+    }
+    EXPECT_FALSE(dropped);
+    EXPECT_EQ(notifier.calls, 0);
+}
+
+TEST(QueuePoolTest, ResetRefusedWhileConsumerParked) {
+    AsyncQueue<int> queue;
+    std::thread consumer([&]() {
+        queue.try_pop(200ms);
+    });
+    std::this_thread::sleep_for(50ms);
+    EXPECT_FALSE(queue.reset());
+    consumer.join();
+    EXPECT_TRUE(queue.reset());
+}
+
+TEST(QueuePoolTest, ReleasedQueueIsReused) {
+    QueuePool<int> pool(8);
+    pool.reserve(2);
+    EXPECT_EQ(pool.idle(), 2);
+
+    AsyncQueue<int>* first = nullptr;
+    {
+        auto queue = pool.acquire();
+        first = queue.get();
+        EXPECT_EQ(pool.idle(), 1);
+        EXPECT_EQ(queue->capacity(), 8);
+        queue->push(1);
+        queue->push(2);
+    }
+    EXPECT_EQ(pool.idle(), 2);
+
+    auto again = pool.acquire();
+    EXPECT_EQ(again.get(), first);
+    EXPECT_FALSE(again->is_closed());
+    EXPECT_TRUE(again->empty());  // Leftovers from the last user are gone
+}
+
+TEST(QueuePoolTest, ReleaseWaitsForBlockedProducer) {
+    for (int run = 0; run < 10; ++run) {
+        QueuePool<int> pool(1);
+        auto queue = pool.acquire();
+        queue->push(0);
+        AsyncQueue<int>* raw = queue.get();
+
+        std::atomic<bool> pushed{true};
+        std::thread producer([raw, &pushed]() {
+            pushed = raw->push(7);  // Barging producer waiting for room
+        });
+        std::this_thread::sleep_for(20ms);
+
+        queue.reset();
+        auto again = pool.acquire();
+        producer.join();
+        EXPECT_FALSE(pushed);
+        EXPECT_TRUE(again->empty());  // Nothing from the last user leaked in
+    }
+}
+
+TEST(QueuePoolTest, ReleaseWaitsForParkedThreads) {
+    QueuePool<int> pool(1);
+    auto queue = pool.acquire();
+    queue->push(0);
+    AsyncQueue<int>* raw = queue.get();
+
+    std::thread producer([raw]() {
+        EXPECT_FALSE(raw->push(1));  // Parked on a full queue
+    });
+    std::thread drainer([raw]() {
+        raw->close_and_drain(std::chrono::steady_clock::now() + 10s);
+    });
+    std::this_thread::sleep_for(50ms);
+
+    queue.reset();  // Returns the queue while both threads wait in it
+    producer.join();
+    drainer.join();
+    EXPECT_EQ(pool.idle(), 1);
+
+    auto again = pool.acquire();
+    EXPECT_EQ(again.get(), raw);
+    EXPECT_TRUE(again->empty());
+}
+
+TEST(QueuePoolTest, IdleQueuesAreBounded) {
+    QueuePool<int> pool(16, Fairness::barging, 1);
+    {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+    }
+    EXPECT_EQ(pool.idle(), 1);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "async_queue/request_queue.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(RequestQueueTest, CallAndReply) {
+    RequestQueue<int, std::string> rpc;
+
+    std::thread server([&]() {
+        while (auto envelope = rpc.pop()) {
+            envelope->responder.reply(std::to_string(envelope->request * 2));
+        }
+    });
+
+    for (int i = 0; i < 100; ++i) {
+        auto reply = rpc.call(i).get();
+        ASSERT_TRUE(reply.has_value());
+        EXPECT_EQ(*reply, std::to_string(i * 2));
+    }
+
+    rpc.close();
+    server.join();
+
+    // Sequential calls keep reusing one slot
+    EXPECT_EQ(rpc.slots_in_use(), 0u);
+}
+
+TEST(RequestQueueTest, DroppedResponderBreaksCall) {
+    RequestQueue<int, int> rpc;
+    auto pending = rpc.call(1);
+
+    rpc.pop();  // Envelope destroyed without a reply
+    EXPECT_FALSE(pending.get().has_value());
+    EXPECT_EQ(rpc.slots_in_use(), 0u);
+}
+
+TEST(RequestQueueTest, TimeoutThenAbandonRecyclesSlot) {
+    RequestQueue<int, int> rpc;
+    {
+        auto pending = rpc.call(1);
+        EXPECT_FALSE(pending.try_get(10ms).has_value());
+        EXPECT_TRUE(pending.valid());
+    }  // Caller gives up
+
+    EXPECT_EQ(rpc.slots_in_use(), 1u);  // Responder still holds the slot
+    auto envelope = rpc.pop();
+    ASSERT_TRUE(envelope.has_value());
+    envelope->responder.reply(5);       // Late reply is discarded
+    EXPECT_EQ(rpc.slots_in_use(), 0u);
+}
+
+TEST(RequestQueueTest, LateReplyAfterTimeoutStillDelivered) {
+    RequestQueue<int, int> rpc;
+    auto pending = rpc.call(7);
+    EXPECT_FALSE(pending.try_get(5ms).has_value());
+
+    auto envelope = rpc.pop();
+    envelope->responder.reply(49);
+    auto reply = pending.try_get(5ms);
+    ASSERT_TRUE(reply.has_value());
+    EXPECT_EQ(*reply, 49);
+    EXPECT_FALSE(pending.valid());
+}
+
+TEST(RequestQueueTest, CallOnClosedQueue) {
+    RequestQueue<int, int> rpc;
+    rpc.close();
+    auto pending = rpc.call(1);
+    EXPECT_FALSE(pending.valid());
+    EXPECT_FALSE(pending.get().has_value());
+    EXPECT_EQ(rpc.slots_in_use(), 0u);
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "async_queue/async_queue.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(ShutdownTest, CloseAndDrainWaitsForConsumers) {
+    AsyncQueue<int> queue;
+    for (int i = 0; i < 5; ++i) {
+        queue.push(i);
+    }
+
+    std::vector<int> consumed;
+    std::thread consumer([&]() {
+        std::this_thread::sleep_for(20ms);
+        while (auto item = queue.pop()) {
+            consumed.push_back(*item);
+        }
+    });
+
+    EXPECT_TRUE(queue.close_and_drain(std::chrono::steady_clock::now() + 5s));
+    EXPECT_TRUE(queue.is_closed());
+    EXPECT_FALSE(queue.push(99));
+    consumer.join();
+    EXPECT_EQ(consumed, (std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+TEST(ShutdownTest, CloseAndDrainTimesOut) {
+    AsyncQueue<int> queue;
+    queue.push(1);
+    queue.push(2);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.close_and_drain(start + 50ms));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 45ms);
+    EXPECT_EQ(queue.size(), 2);  // Leftovers stay queued
+}
+
+TEST(ShutdownTest, AbortReturnsPendingItems) {
+    AsyncQueue<std::unique_ptr<int>> queue;
+    queue.push(std::make_unique<int>(1));
+    auto h = queue.push_tracked(std::make_unique<int>(2));
+    queue.push(std::make_unique<int>(3));
+    ASSERT_TRUE(h);
+    queue.cancel(*h);
+
+    auto pending = queue.abort();
+    EXPECT_TRUE(queue.is_closed());
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop().has_value());
+
+    ASSERT_EQ(pending.size(), 2);
+    std::vector<int> values;
+    for (auto& item : pending) {
+        values.push_back(*item);
+    }
+    EXPECT_EQ(values, (std::vector<int>{1, 3}));
+}
+
+TEST(ShutdownTest, AbortReleasesDrainAndBlockedThreads) {
+    AsyncQueue<int> queue(1);
+    queue.push(1);
+
+    std::atomic<bool> push_result{true};
+    std::thread producer([&]() {
+        push_result = queue.push(2);  // Blocks: queue is full
+    });
+    std::atomic<bool> drained{false};
+    std::thread drainer([&]() {
+        drained = queue.close_and_drain(std::chrono::steady_clock::now() + 5s);
+    });
+
+    std::this_thread::sleep_for(20ms);
+    auto pending = queue.abort();
+    producer.join();
+    drainer.join();
+
+    EXPECT_FALSE(push_result);
+    EXPECT_TRUE(drained);
+    EXPECT_EQ(pending.size(), 1);
+    EXPECT_EQ(*pending.begin(), 1);
+}
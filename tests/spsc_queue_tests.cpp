@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "async_queue/spsc_queue.hpp"
+#include <memory>
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+namespace {
+
+template<typename Wait>
+void expect_ordered_transfer(size_t capacity, int count) {
+    SpscQueue<int, Wait> queue(capacity);
+    std::thread producer([&]() {
+        for (int i = 0; i < count; ++i) {
+            ASSERT_TRUE(queue.push(i));
+        }
+        queue.close();
+    });
+
+    int expected = 0;
+    while (auto item = queue.pop()) {
+        ASSERT_EQ(*item, expected++);
+    }
+    EXPECT_EQ(expected, count);
+    producer.join();
+}
+
+} // namespace
+
+TEST(SpscQueueTest, TransfersInOrderWhenParking) {
+    expect_ordered_transfer<opt::park>(4, 100000);
+}
+
+TEST(SpscQueueTest, TransfersInOrderWhenSpinning) {
+    expect_ordered_transfer<opt::spin_then_park>(64, 100000);
+}
+
+TEST(SpscQueueTest, TimeoutsAndCapacity) {
+    SpscQueue<int> queue(3);
+    EXPECT_EQ(queue.capacity(), 3u);
+    EXPECT_FALSE(queue.try_pop(10ms).has_value());
+
+    EXPECT_TRUE(queue.try_push(1, 10ms));
+    EXPECT_TRUE(queue.try_push(2, 10ms));
+    EXPECT_TRUE(queue.try_push(3, 10ms));
+    EXPECT_FALSE(queue.try_push(4, 10ms));  // Full, even though the ring has 4 slots
+    EXPECT_EQ(queue.size(), 3u);
+
+    EXPECT_EQ(queue.try_pop(10ms), std::optional<int>(1));
+    EXPECT_TRUE(queue.try_push(4, 10ms));
+}
+
+TEST(SpscQueueTest, CloseDrainsAndWakesBothSides) {
+    SpscQueue<std::unique_ptr<int>> queue(1);
+    queue.push(std::make_unique<int>(1));
+
+    std::thread blocked_producer([&]() {
+        EXPECT_FALSE(queue.push(std::make_unique<int>(2)));
+    });
+    std::this_thread::sleep_for(20ms);
+    queue.close();
+    blocked_producer.join();
+
+    auto item = queue.pop();
+    ASSERT_TRUE(item.has_value());
+    EXPECT_EQ(**item, 1);
+    EXPECT_FALSE(queue.pop().has_value());
+    EXPECT_FALSE(queue.push(std::make_unique<int>(3)));
+}
+
+TEST(SpscQueueTest, DestroysPendingItems) {
+    auto tracked = std::make_shared<int>(0);
+    {
+        SpscQueue<std::shared_ptr<int>> queue(8);
+        queue.push(tracked);
+        queue.push(tracked);
+        EXPECT_EQ(tracked.use_count(), 3);
+    }
+    EXPECT_EQ(tracked.use_count(), 1);
+}
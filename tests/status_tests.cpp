@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "async_queue/async_queue.hpp"
+#include <memory>
+#include <thread>
+#include <chrono>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(StatusTest, PopDistinguishesTimeoutEmptyAndClosed) {
+    AsyncQueue<int> queue;
+    int out = 0;
+
+    EXPECT_EQ(queue.try_pop_status(out), QueueStatus::empty);
+    EXPECT_EQ(queue.try_pop_status(out, 10ms), QueueStatus::timeout);
+
+    queue.push(1);
+    queue.close();
+    EXPECT_EQ(queue.try_pop_status(out, 10ms), QueueStatus::ok);
+    EXPECT_EQ(out, 1);
+
+    EXPECT_EQ(queue.try_pop_status(out), QueueStatus::closed);
+    EXPECT_EQ(queue.try_pop_status(out, 10ms), QueueStatus::closed);
+    EXPECT_EQ(queue.pop_status(out), QueueStatus::closed);
+}
+
+TEST(StatusTest, BlockingPopReportsClose) {
+    AsyncQueue<int> queue;
+    std::thread closer([&]() {
+        std::this_thread::sleep_for(20ms);
+        queue.close();
+    });
+    int out = 0;
+    EXPECT_EQ(queue.pop_status(out), QueueStatus::closed);
+    closer.join();
+}
+
+TEST(StatusTest, FailedPushKeepsMoveOnlyItem) {
+    AsyncQueue<std::unique_ptr<int>> queue(1);
+    EXPECT_EQ(queue.try_push_status(std::make_unique<int>(1)), QueueStatus::ok);
+
+    auto item = std::make_unique<int>(2);
+    EXPECT_EQ(queue.try_push_status(std::move(item)), QueueStatus::full);
+    ASSERT_TRUE(item);
+    EXPECT_EQ(queue.try_push_status(std::move(item), 10ms), QueueStatus::timeout);
+    ASSERT_TRUE(item);
+
+    queue.close();
+    EXPECT_EQ(queue.push_status(std::move(item)), QueueStatus::closed);
+    EXPECT_EQ(queue.try_push_status(std::move(item)), QueueStatus::closed);
+    ASSERT_TRUE(item);
+    EXPECT_EQ(*item, 2);
+
+    std::unique_ptr<int> out;
+    EXPECT_EQ(queue.pop_status(out), QueueStatus::ok);
+    EXPECT_EQ(*out, 1);
+}
+
+TEST(StatusTest, PushStatusWaitsForRoom) {
+    AsyncQueue<int> queue(1);
+    queue.push(1);
+
+    std::thread consumer([&]() {
+        std::this_thread::sleep_for(20ms);
+        queue.pop();
+    });
+    EXPECT_EQ(queue.push_status(2), QueueStatus::ok);
+    consumer.join();
+    EXPECT_EQ(*queue.pop(), 2);
+}
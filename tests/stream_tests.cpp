@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "async_queue/stream.hpp"
+#include <string>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+TEST(StreamTest, FusedConsumerChain) {
+    AsyncQueue<int> queue;
+    for (int i = 1; i <= 10; ++i) {
+        queue.push(i);
+    }
+    queue.close();
+
+    auto evens = queue
+        | filter([](int n) { return n % 2 == 0; })
+        | map([](int n) { return std::to_string(n * 10); })
+        | batch(2);
+
+    std::vector<std::vector<std::string>> batches;
+    while (auto b = evens.pop()) {
+        batches.push_back(std::move(*b));
+    }
+    ASSERT_EQ(batches.size(), 3u);
+    EXPECT_EQ(batches[0], (std::vector<std::string>{"20", "40"}));
+    EXPECT_EQ(batches[1], (std::vector<std::string>{"60", "80"}));
+    EXPECT_EQ(batches[2], (std::vector<std::string>{"100"}));  // Partial, after close
+}
+
+TEST(StreamTest, TryPopTimesOutAndCloseReachesQueue) {
+    AsyncQueue<int> queue;
+    auto doubled = queue | map([](int n) { return n * 2; });
+
+    EXPECT_FALSE(doubled.try_pop(10ms).has_value());
+    queue.push(21);
+    EXPECT_EQ(*doubled.try_pop(10ms), 42);
+
+    doubled.close();
+    EXPECT_TRUE(queue.is_closed());
+    EXPECT_FALSE(doubled.pop().has_value());
+}
+
+TEST(StreamTest, FilterSkipsWithinDeadline) {
+    AsyncQueue<int> queue;
+    auto odd = queue | filter([](int n) { return n % 2 == 1; });
+    std::thread producer([&]() {
+        queue.push(2);
+        queue.push(4);
+        std::this_thread::sleep_for(10ms);
+        queue.push(5);
+    });
+    EXPECT_EQ(*odd.try_pop(1s), 5);
+    producer.join();
+}
+
+TEST(StreamTest, FusedProducerChain) {
+    AsyncQueue<std::vector<std::string>> queue;
+    auto sink = pipe<int>()
+        | filter([](int n) { return n > 0; })
+        | map([](int n) { return std::string(static_cast<size_t>(n), '*'); })
+        | batch(2)
+        | into(queue);
+
+    EXPECT_TRUE(sink.push(1));
+    EXPECT_TRUE(sink.push(-5));  // Filtered out
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_TRUE(sink.push(2));
+    EXPECT_EQ(queue.size(), 1u);
+    EXPECT_TRUE(sink.push(3));
+
+    sink.close();  // Flushes the partial batch, then closes
+    EXPECT_TRUE(queue.is_closed());
+    EXPECT_EQ(*queue.pop(), (std::vector<std::string>{"*", "**"}));
+    EXPECT_EQ(*queue.pop(), (std::vector<std::string>{"***"}));
+    EXPECT_FALSE(queue.pop().has_value());
+    EXPECT_FALSE(sink.push(4));
+}
+
+TEST(StreamTest, BatchSinkSharedByProducers) {
+    AsyncQueue<std::vector<int>> queue;
+    auto sink = pipe<int>() | batch(7) | into(queue);
+    constexpr int producers = 4;
+    constexpr int per_producer = 1000;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&sink]() {
+            for (int i = 0; i < per_producer; ++i) {
+                EXPECT_TRUE(sink.push(1));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    sink.close();
+
+    size_t total = 0;
+    while (auto items = queue.pop()) {
+        EXPECT_LE(items->size(), 7u);
+        total += items->size();
+    }
+    EXPECT_EQ(total, static_cast<size_t>(producers * per_producer));
+}
+
+TEST(StreamTest, StagesBetweenTwoQueuesWithoutExtraThread) {
+    AsyncQueue<int> input;
+    AsyncQueue<int> output;
+    auto to_output = pipe<int>() | map([](int n) { return n + 1; }) | into(output);
+    auto from_input = input | filter([](int n) { return n != 3; });
+
+    for (int i = 0; i < 5; ++i) {
+        input.push(i);
+    }
+    input.close();
+    while (auto n = from_input.pop()) {
+        to_output.push(*n);
+    }
+    to_output.close();
+
+    std::vector<int> seen;
+    while (auto n = output.pop()) {
+        seen.push_back(*n);
+    }
+    EXPECT_EQ(seen, (std::vector<int>{1, 2, 3, 5}));
+}
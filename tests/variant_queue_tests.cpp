@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "async_queue/variant_queue.hpp"
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace async_queue;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Ping {
+    uint32_t id;
+};
+
+struct Snapshot {
+    std::array<char, 120> data;
+};
+
+using Message = std::variant<Ping, std::string, Snapshot, std::unique_ptr<int>>;
+
+} // namespace
+
+// Small alternatives get small slots instead of sizeof(Message).
+static_assert(VariantQueue<Message>::slot_size<0> == 8);
+static_assert(VariantQueue<Message>::slot_size<2> == 128);
+static_assert(VariantQueue<Message>::slot_size<0> < sizeof(Message));
+
+TEST(VariantQueueTest, KeepsOrderAcrossSizeClasses) {
+    VariantQueue<Message> queue(16);
+    queue.push(Ping{1});
+    queue.push(std::string("two"));
+    queue.push(Message(Snapshot{}));
+    queue.push(std::make_unique<int>(4));
+    queue.push(Ping{5});
+
+    auto first = queue.pop();
+    ASSERT_TRUE(first && std::holds_alternative<Ping>(*first));
+    EXPECT_EQ(std::get<Ping>(*first).id, 1u);
+    EXPECT_EQ(std::get<std::string>(*queue.pop()), "two");
+    EXPECT_EQ(queue.pop()->index(), 2u);
+    EXPECT_EQ(*std::get<std::unique_ptr<int>>(*queue.pop()), 4);
+    EXPECT_EQ(std::get<Ping>(*queue.pop()).id, 5u);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(VariantQueueTest, PopVisitGetsAlternativeDirectly) {
+    VariantQueue<Message> queue(4);
+    queue.push(std::string("text"));
+    queue.push(Ping{9});
+
+    std::vector<std::string> seen;
+    auto visitor = [&](auto& item) {
+        using A = std::decay_t<decltype(item)>;
+        if constexpr (std::is_same_v<A, Ping>) {
+            seen.push_back("ping " + std::to_string(item.id));
+        } else if constexpr (std::is_same_v<A, std::string>) {
+            seen.push_back(item);
+        } else {
+            seen.push_back("other");
+        }
+    };
+    EXPECT_TRUE(queue.pop_visit(visitor));
+    EXPECT_TRUE(queue.pop_visit(visitor));
+    EXPECT_FALSE(queue.try_pop_visit(visitor, 10ms));
+    EXPECT_EQ(seen, (std::vector<std::string>{"text", "ping 9"}));
+}
+
+TEST(VariantQueueTest, BoundedAndClosable) {
+    VariantQueue<Message> queue(2);
+    queue.push(Ping{1});
+    queue.push(Ping{2});
+
+    auto item = std::make_unique<int>(3);
+    EXPECT_FALSE(queue.try_push(std::move(item), 20ms));
+    EXPECT_TRUE(item);  // Not moved from on failure
+
+    std::thread consumer([&]() {
+        std::this_thread::sleep_for(20ms);
+        queue.pop();
+    });
+    EXPECT_TRUE(queue.push(std::move(item)));
+    consumer.join();
+
+    queue.close();
+    EXPECT_FALSE(queue.push(Ping{4}));
+    EXPECT_EQ(std::get<Ping>(*queue.pop()).id, 2u);
+    EXPECT_TRUE(queue.pop().has_value());
+    EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST(VariantQueueTest, ThrowingConstructorStoresNothing) {
+    struct Fragile {
+        Fragile() = default;
+        Fragile(const Fragile&) { throw std::runtime_error("copy failed"); }
+        uint32_t id = 0;
+    };
+    // Fragile shares Ping's size class, and with it Ping's ring.
+    VariantQueue<std::variant<Ping, Fragile>> queue(4);
+    queue.push(Ping{1});
+    Fragile fragile;
+    EXPECT_THROW(queue.push(fragile), std::runtime_error);
+    queue.push(Ping{2});
+
+    EXPECT_EQ(queue.size(), 2u);
+    EXPECT_EQ(std::get<Ping>(*queue.pop()).id, 1u);
+    EXPECT_EQ(std::get<Ping>(*queue.pop()).id, 2u);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(VariantQueueTest, WrapsAroundUnderLoad) {
+    VariantQueue<Message> queue(8);
+    constexpr uint32_t count = 10000;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (i % 5 == 0) {
+                queue.push(std::to_string(i));
+            } else {
+                queue.push(Ping{i});
+            }
+        }
+        queue.close();
+    });
+
+    uint32_t next = 0;
+    while (auto msg = queue.pop()) {
+        if (next % 5 == 0) {
+            EXPECT_EQ(std::get<std::string>(*msg), std::to_string(next));
+        } else {
+            EXPECT_EQ(std::get<Ping>(*msg).id, next);
+        }
+        ++next;
+    }
+    producer.join();
+    EXPECT_EQ(next, count);
+}